@@ -4,7 +4,7 @@ dst=/tmp
 path=example
 
 flags=(-I include -m64 -std=c++23 -s -Wall -O3)
-executables=(arity curry tensor object_pool is_lambda stream ycombinator sort_tuple unique_tuple memoized_invoke tuple_algorithm compiler_detector loop_unroll)
+executables=(arity curry tensor object_pool object_pool_allocations shm_ring is_lambda stream ycombinator sort_tuple unique_tuple memoized_invoke memoized_invoke_benchmark tuple_algorithm compiler_detector loop_unroll)
 
 for bin in ${executables[@]}; do
       g++ "${flags[@]}" -o ${dst}/${bin} ${path}/${bin}.cpp
@@ -14,6 +14,8 @@ for bin in monster overview; do
       g++ "${flags[@]}" -o ${dst}/${bin} ${path}/${bin}.cpp
 done
 
-g++ "${flags[@]}" -l pthread -o ${dst}/thread_pool ${path}/thread_pool.cpp
+for bin in thread_pool thread_pool_allocations object_pool_stress pool_resource thread_pool_benchmark thread_pool_contention ring_benchmark; do
+      g++ "${flags[@]}" -l pthread -o ${dst}/${bin} ${path}/${bin}.cpp
+done
 
 echo Please check the executables at ${dst}
@@ -9,6 +9,8 @@
 
 // g++ -I include -m64 -std=c++23 -s -Wall -O3 -o /tmp/memoized_invoke example/memoized_invoke.cpp
 
+#include <string>
+#include <iostream>
 #include <memoized_invoke.hpp>
 
 using namespace monster;
@@ -22,5 +24,31 @@ int main(int argc, char* argv[])
 
     fib(8);
 
+    std::function<long(int)> hfib = memoized_invoke<hashed_table>([&](int n) -> long
+    {
+        return n < 2 ? n : hfib(n - 1) + hfib(n - 2);
+    });
+
+    hfib(80);
+
+    auto length = memoized_invoke<hashed_table>([](const std::string& s)
+    {
+        return s.size();
+    });
+
+    length(std::string_view("hashed without building a std::string on a hit"));
+
+    auto square = memoized_invoke<lru_table>([](int n)
+    {
+        return n * n;
+    }, 2);
+
+    square(1);
+    square(2);
+    square(1);
+    square(3);
+
+    std::cout << square.hits() << " " << square.misses() << " " << square.size() << std::endl;
+
     return 0;
 }
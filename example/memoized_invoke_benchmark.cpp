@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+// g++ -I include -m64 -std=c++23 -s -Wall -O3 -o /tmp/memoized_invoke_benchmark example/memoized_invoke_benchmark.cpp
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <string_view>
+#include <memoized_invoke.hpp>
+
+using namespace monster;
+
+constexpr size_t keys = 10000;
+constexpr size_t calls = 2000000;
+
+// keeps the results observable, so the calls are not optimized away
+
+volatile size_t sink;
+
+// calls a memoized function over a warm table, every call is a hit, in million calls per second
+
+template <typename M, typename Args>
+double hits(M& m, const Args& args)
+{
+    for (auto& arg : args)
+         m(arg);
+
+    size_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i != calls; ++i)
+         sum += m(args[i % args.size()]);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    sink = sum;
+
+    return calls / elapsed.count() / 1e6;
+}
+
+template <template <typename, typename> typename Table>
+void integers(const char* name)
+{
+    std::vector<std::pair<int, int>> pairs;
+
+    for (size_t i = 0; i != keys; ++i)
+         pairs.emplace_back(i * 7919, i + 1);
+
+    auto f = memoized_invoke<Table>([](int a, int b){ return size_t(a) * b; });
+
+    auto g = [&](const std::pair<int, int>& p){ return f(p.first, p.second); };
+
+    std::cout << name << " (int, int) " << hits(g, pairs) << " M/s" << std::endl;
+}
+
+// the strings are looked up by string_view, the ordered table builds a std::string key on every call
+
+template <template <typename, typename> typename Table>
+void strings(const char* name)
+{
+    std::vector<std::string> owned;
+
+    for (size_t i = 0; i != keys; ++i)
+         owned.push_back("a key long enough to live on the heap " + std::to_string(i));
+
+    std::vector<std::string_view> views(owned.begin(), owned.end());
+
+    auto f = memoized_invoke<Table>([](const std::string& s){ return s.size(); });
+
+    std::cout << name << " (string_view) " << hits(f, views) << " M/s" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    integers<ordered_table>("ordered_table");
+    integers<hashed_table>("hashed_table");
+
+    strings<ordered_table>("ordered_table");
+    strings<hashed_table>("hashed_table");
+
+    return 0;
+}
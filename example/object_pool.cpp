@@ -63,5 +63,12 @@ int main(int argc, char* argv[])
          process_expensive_object(req);
     }
 
+    {
+        object_pool_unique_t<expensive_object> unique = pools.allocate_unique();
+        object_pool_intrusive_t<expensive_object> shared = std::move(unique);
+
+        auto copy = shared;
+    }
+
     return 0;
 }
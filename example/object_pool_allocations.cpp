@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+// g++ -I include -m64 -std=c++23 -s -Wall -O3 -o /tmp/object_pool_allocations example/object_pool_allocations.cpp
+
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <object_pool.hpp>
+
+using namespace monster;
+
+// every heap allocation of the process goes through here
+
+std::atomic<size_t> allocations = 0;
+
+void* operator new(size_t n)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto p = std::malloc(n ? n : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+struct message
+{
+    size_t id = 0;
+};
+
+constexpr size_t rounds = 2000000;
+
+// allocates, copies or moves the handle once and releases, the object itself always comes from the pool
+
+template <typename F>
+size_t churn(const char* name, F&& f)
+{
+    auto before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i != rounds; ++i)
+         f(i);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    auto count = allocations.load() - before;
+
+    std::cout << name << " " << rounds / elapsed.count() / 1e6 << " M/s, " << count << " allocations" << std::endl;
+
+    return count;
+}
+
+int main(int argc, char* argv[])
+{
+    object_pool<message> pool;
+
+    // the first allocation of a thread sets up its cache
+    pool.allocate_unique();
+
+    churn("shared_ptr", [&](size_t i)
+    {
+        object_pool_t<message> p = pool.allocate();
+        auto copy = p;
+
+        copy->id = i;
+    });
+
+    auto unique = churn("unique_handle", [&](size_t i)
+    {
+        object_pool_unique_t<message> p = pool.allocate_unique();
+        auto moved = std::move(p);
+
+        moved->id = i;
+    });
+
+    auto intrusive = churn("intrusive_handle", [&](size_t i)
+    {
+        object_pool_intrusive_t<message> p = pool.allocate_intrusive();
+        auto copy = p;
+
+        copy->id = i;
+    });
+
+    return unique == 0 && intrusive == 0 ? 0 : 1;
+}
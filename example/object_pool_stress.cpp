@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+// g++ -I include -m64 -std=c++23 -s -Wall -O3 -l pthread -o /tmp/object_pool_stress example/object_pool_stress.cpp
+
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <object_pool.hpp>
+
+using namespace monster;
+
+struct message
+{
+    size_t owner = 0;
+    std::vector<char> payload = std::vector<char>(64);
+};
+
+using pool_type = object_pool<message, 64>;
+
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "failed: " << what << std::endl;
+        std::abort();
+    }
+}
+
+// every thread allocates, hands half of its objects to its neighbour and releases what it was handed,
+// so objects keep moving between the magazines of different threads
+
+void cross_thread(size_t threads, size_t rounds)
+{
+    pool_type pool(256, [](message& m){ m.owner = 0; });
+
+    std::vector<std::mutex> locks(threads);
+    std::vector<std::vector<object_pool_unique_t<message, 64>>> inboxes(threads);
+
+    std::vector<std::thread> workers;
+
+    for (size_t t = 0; t != threads; ++t)
+    {
+         workers.emplace_back([&, t]
+         {
+             std::vector<object_pool_unique_t<message, 64>> mine;
+
+             for (size_t r = 0; r != rounds; ++r)
+             {
+                  for (size_t i = 0; i != 16; ++i)
+                  {
+                       auto h = pool.allocate_unique();
+                       check(h->owner == 0, "a pooled object came back without its reset");
+
+                       h->owner = t + 1;
+                       mine.push_back(std::move(h));
+                  }
+
+                  {
+                      std::lock_guard<std::mutex> lock(locks[(t + 1) % threads]);
+
+                      for (size_t i = 0; i != 8; ++i)
+                           inboxes[(t + 1) % threads].push_back(std::move(mine[i]));
+                  }
+
+                  mine.clear();
+
+                  std::vector<object_pool_unique_t<message, 64>> received;
+
+                  {
+                      std::lock_guard<std::mutex> lock(locks[t]);
+                      received.swap(inboxes[t]);
+                  }
+
+                  for (auto& h : received)
+                       check(h->owner == (t + threads - 1) % threads + 1, "an object was handed to two owners");
+             }
+         });
+    }
+
+    for (auto& w : workers)
+         w.join();
+
+    for (auto& inbox : inboxes)
+         inbox.clear();
+
+    auto stats = pool.snapshot();
+
+    check(stats.outstanding == 0, "outstanding after every handle is released");
+    check(stats.live >= stats.retained && stats.high_water >= stats.live, "live outside retained and high water");
+
+    std::cout << "cross thread " << threads << " threads, hits " << stats.hits << " misses " << stats.misses
+              << " live " << stats.live << " high water " << stats.high_water << std::endl;
+}
+
+// handles outlive the pool, are shared across threads and are released by threads whose caches are already gone
+
+void outliving(size_t threads)
+{
+    for (size_t round = 0; round != 50; ++round)
+    {
+         auto pool = std::make_unique<pool_type>();
+
+         std::vector<object_pool_intrusive_t<message, 64>> held(threads);
+         std::vector<std::thread> workers;
+
+         for (size_t t = 0; t != threads; ++t)
+         {
+              workers.emplace_back([&, t]
+              {
+                  // constructed before the pool's thread state, so destroyed after it
+
+                  thread_local object_pool_unique_t<message, 64> late;
+
+                  late = pool->allocate_unique();
+                  held[t] = pool->allocate_intrusive();
+              });
+         }
+
+         for (auto& w : workers)
+              w.join();
+
+         check(pool->snapshot().outstanding == threads, "outstanding with one shared handle per thread");
+
+         std::thread last([&]
+         {
+             auto copies = held;
+
+             held.clear();
+             pool.reset();
+         });
+
+         last.join();
+    }
+
+    std::cout << "outliving " << threads << " threads ok" << std::endl;
+}
+
+// allocate and release in a tight loop, against a make_shared per object
+
+template <typename F>
+double measure(size_t threads, size_t n, F&& f)
+{
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t t = 0; t != threads; ++t)
+         workers.emplace_back([&]{ f(n); });
+
+    for (auto& w : workers)
+         w.join();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return threads * n / elapsed.count() / 1e6;
+}
+
+void benchmark(size_t threads, size_t n)
+{
+    pool_type pool;
+
+    auto pooled = measure(threads, n, [&](size_t n)
+    {
+        for (size_t i = 0; i != n; ++i)
+        {
+             auto h = pool.allocate_unique();
+             h->owner = i;
+        }
+    });
+
+    auto heap = measure(threads, n, [](size_t n)
+    {
+        for (size_t i = 0; i != n; ++i)
+        {
+             auto p = std::make_shared<message>();
+             p->owner = i;
+        }
+    });
+
+    std::cout << threads << " threads: object_pool " << pooled << " M/s, make_shared " << heap << " M/s" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+
+    cross_thread(2, 20000);
+    cross_thread(cores, 5000);
+
+    outliving(cores);
+
+    for (size_t threads : { size_t(1), size_t(2), cores })
+         benchmark(threads, 1000000);
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+// g++ -I include -m64 -std=c++23 -s -Wall -O3 -l pthread -o /tmp/pool_resource example/pool_resource.cpp
+
+#include <list>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <unordered_map>
+#include <object_pool.hpp>
+
+using namespace monster;
+
+constexpr size_t rounds = 20;
+constexpr size_t keys = 100000;
+
+// node container insert and erase throughput, in million operations per second
+
+template <typename F>
+double measure(size_t ops, F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return ops / elapsed.count() / 1e6;
+}
+
+template <typename Map>
+double churn_map(Map&& m)
+{
+    return measure(rounds * keys * 2, [&]
+    {
+        for (size_t r = 0; r != rounds; ++r)
+        {
+             for (size_t i = 0; i != keys; ++i)
+                  m.emplace(i, i);
+
+             for (size_t i = 0; i != keys; ++i)
+                  m.erase(i);
+        }
+    });
+}
+
+template <typename List>
+double churn_list(List&& l)
+{
+    return measure(rounds * keys * 2, [&]
+    {
+        for (size_t r = 0; r != rounds; ++r)
+        {
+             for (size_t i = 0; i != keys; ++i)
+                  l.push_back(i);
+
+             l.clear();
+        }
+    });
+}
+
+template <typename F>
+double threaded(size_t threads, F&& f)
+{
+    return measure(threads * rounds * keys * 2, [&]
+    {
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t != threads; ++t)
+             workers.emplace_back(f);
+
+        for (auto& w : workers)
+             w.join();
+    });
+}
+
+int main(int argc, char* argv[])
+{
+    {
+        std::cout << "unordered_map new/delete " << churn_map(std::unordered_map<size_t, size_t>()) << " M/s" << std::endl;
+
+        pool_resource pool;
+        std::cout << "unordered_map pool_resource " << churn_map(std::pmr::unordered_map<size_t, size_t>(&pool)) << " M/s" << std::endl;
+
+        std::pmr::unsynchronized_pool_resource unsynchronized;
+        std::cout << "unordered_map unsynchronized_pool_resource " << churn_map(std::pmr::unordered_map<size_t, size_t>(&unsynchronized)) << " M/s" << std::endl;
+
+        std::pmr::synchronized_pool_resource synchronized;
+        std::cout << "unordered_map synchronized_pool_resource " << churn_map(std::pmr::unordered_map<size_t, size_t>(&synchronized)) << " M/s" << std::endl;
+    }
+
+    {
+        std::cout << "list new/delete " << churn_list(std::list<size_t>()) << " M/s" << std::endl;
+
+        pool_resource pool;
+        std::cout << "list pool_resource " << churn_list(std::pmr::list<size_t>(&pool)) << " M/s" << std::endl;
+
+        arena_resource arena;
+        std::cout << "list arena_resource " << churn_list(std::pmr::list<size_t>(&arena)) << " M/s" << std::endl;
+    }
+
+    {
+        size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+
+        std::cout << threads << " threads unordered_map new/delete " << threaded(threads, []
+        {
+            churn_map(std::unordered_map<size_t, size_t>());
+        }) << " M/s" << std::endl;
+
+        pool_resource pool;
+
+        std::cout << threads << " threads unordered_map shared pool_resource " << threaded(threads, [&]
+        {
+            churn_map(std::pmr::unordered_map<size_t, size_t>(&pool));
+        }) << " M/s" << std::endl;
+
+        std::pmr::synchronized_pool_resource synchronized;
+
+        std::cout << threads << " threads unordered_map shared synchronized_pool_resource " << threaded(threads, [&]
+        {
+            churn_map(std::pmr::unordered_map<size_t, size_t>(&synchronized));
+        }) << " M/s" << std::endl;
+    }
+
+    {
+        pool_resource pool;
+        std::pmr::vector<std::pmr::string> strings(&pool);
+
+        for (size_t i = 0; i != 1000; ++i)
+             strings.emplace_back("a string too long for the small string buffer");
+
+        auto stats = pool.snapshot(sizeof("a string too long for the small string buffer"));
+        std::cout << "strings hits " << stats.hits << " misses " << stats.misses << " outstanding " << stats.outstanding << std::endl;
+    }
+
+    return 0;
+}
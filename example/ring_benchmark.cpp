@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+// g++ -I include -m64 -std=c++23 -s -Wall -O3 -l pthread -o /tmp/ring_benchmark example/ring_benchmark.cpp
+
+#include <span>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cstdlib>
+#include <iostream>
+#include <type_traits>
+#include <ring.hpp>
+
+using namespace monster;
+
+template <typename F>
+double measure(size_t n, F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return n / elapsed.count() / 1e6;
+}
+
+// spins a while on an empty or full ring before giving up the cpu, so a round trip is not a pair of syscalls
+
+template <typename R>
+size_t take(R& r)
+{
+    for (size_t spins = 0; ; ++spins)
+    {
+         if (auto v = r.pop())
+             return *v;
+
+         if (spins > 64)
+             std::this_thread::yield();
+    }
+}
+
+// an unbounded ring never refuses a value, its producer backs off now and then so the ring does not grow without end
+
+template <typename R>
+void give(R& r, size_t v)
+{
+    if constexpr (std::is_void_v<decltype(r.push(v))>)
+    {
+        r.push(v);
+
+        if (r.size() > 65536)
+            std::this_thread::yield();
+    }
+    else
+    {
+        for (size_t spins = 0; !r.push(v); ++spins)
+        {
+             if (spins > 64)
+                 std::this_thread::yield();
+        }
+    }
+}
+
+// one value bounces between two threads through a pair of rings, in million round trips per second
+
+template <typename R>
+double ping_pong(R& ping, R& pong, size_t n)
+{
+    return measure(n, [&]
+    {
+        std::thread echo([&]
+        {
+            for (size_t i = 0; i != n; ++i)
+                 give(pong, take(ping));
+        });
+
+        for (size_t i = 0; i != n; ++i)
+        {
+             give(ping, i);
+
+             if (take(pong) != i)
+                 std::abort();
+        }
+
+        echo.join();
+    });
+}
+
+// a producer streams values to a consumer through one ring, in million values per second
+
+template <typename R>
+double stream(R& r, size_t n)
+{
+    return measure(n, [&]
+    {
+        std::thread consumer([&]
+        {
+            for (size_t i = 0; i != n; ++i)
+            {
+                 if (take(r) != i)
+                     std::abort();
+            }
+        });
+
+        for (size_t i = 0; i != n; ++i)
+             give(r, i);
+
+        consumer.join();
+    });
+}
+
+// streams through a ring of each kind, a capacity of 1000 advances its indices by modulo, 1024 by a mask,
+// std::dynamic_extent takes the capacity at run time and allocates it on the heap
+
+template <typename R, typename... Args>
+void streams(const char* name, Args... args)
+{
+    auto r = std::make_unique<R>(args...);
+    std::cout << "stream " << name << " " << stream(*r, 20000000) << " M/s" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    {
+        auto ping = std::make_unique<ring<size_t, 1024>>();
+        auto pong = std::make_unique<ring<size_t, 1024>>();
+
+        std::cout << "ping pong ring " << ping_pong(*ping, *pong, 200000) << " M/s" << std::endl;
+    }
+
+    {
+        auto ping = std::make_unique<spsc_ring<size_t, 1024>>();
+        auto pong = std::make_unique<spsc_ring<size_t, 1024>>();
+
+        std::cout << "ping pong spsc_ring " << ping_pong(*ping, *pong, 200000) << " M/s" << std::endl;
+    }
+
+    streams<ring<size_t, 1000>>("ring<1000>");
+    streams<ring<size_t, 1024>>("ring<1024>");
+    streams<ring<size_t, std::dynamic_extent>>("ring<dynamic_extent>", 1024);
+
+    streams<spsc_ring<size_t, 1000>>("spsc_ring<1000>");
+    streams<spsc_ring<size_t, 1024>>("spsc_ring<1024>");
+    streams<spsc_ring<size_t, std::dynamic_extent>>("spsc_ring<dynamic_extent>", 1024);
+
+    streams<segmented_ring<size_t, 1024>>("segmented_ring<1024>");
+
+    return 0;
+}
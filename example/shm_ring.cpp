@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+// g++ -I include -m64 -std=c++23 -s -Wall -O3 -o /tmp/shm_ring example/shm_ring.cpp
+
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <sys/wait.h>
+#include <shm_ring.hpp>
+
+using namespace monster;
+
+struct quote
+{
+    uint64_t sequence;
+    double bid;
+    double ask;
+};
+
+// a process that restarts attaches to a ring that has been used before, neither role may trust index zero
+
+bool reattach()
+{
+    auto ring = shm_ring<uint64_t>::create(8);
+
+    {
+        auto consumer = shm_ring<uint64_t>::attach(ring.fd());
+
+        for (uint64_t i = 0; i != 5; ++i)
+        {
+             if (!ring.push(i) || consumer.pop() != i)
+                 return false;
+        }
+    }
+
+    auto consumer = shm_ring<uint64_t>::attach(ring.fd());
+
+    if (consumer.pop() || ring.size() != 0)
+        return false;
+
+    auto producer = shm_ring<uint64_t>::attach(ring.fd());
+    size_t pushed = 0;
+
+    while (pushed != 100 && producer.push(pushed))
+        ++pushed;
+
+    if (pushed != ring.capacity())
+        return false;
+
+    for (uint64_t i = 0; i != pushed; ++i)
+    {
+         if (consumer.pop() != i)
+             return false;
+    }
+
+    return ring.empty();
+}
+
+int main(int argc, char* argv[])
+{
+    std::cout << (reattach() ? "reattach ok" : "reattach failed") << std::endl;
+
+    constexpr uint64_t count = 1000000;
+
+    // the child inherits the memfd, so both processes map the same ring
+    auto quotes = shm_ring<quote>::create(1024);
+
+    if (auto pid = fork(); pid == 0)
+    {
+        auto consumer = shm_ring<quote>::attach(quotes.fd());
+
+        uint64_t expected = 0;
+        double spread = 0;
+
+        while (expected != count)
+        {
+            if (auto q = consumer.pop())
+            {
+                if (q->sequence != expected++)
+                    return 1;
+
+                spread += q->ask - q->bid;
+            }
+            else
+                std::this_thread::yield();
+        }
+
+        return spread == count ? 0 : 1;
+    }
+    else
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (uint64_t i = 0; i != count;)
+        {
+            if (quotes.push({ i, 100.0 + i, 101.0 + i }))
+                ++i;
+            else
+                std::this_thread::yield();
+        }
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << (WIFEXITED(status) && WEXITSTATUS(status) == 0 ? "ok " : "failed ") << count / elapsed.count() / 1e6 << " M records/s" << std::endl;
+    }
+
+    return 0;
+}
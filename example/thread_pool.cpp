@@ -9,12 +9,31 @@
 
 // g++ -I include -m64 -std=c++23 -s -Wall -O3 -l pthread -o /tmp/thread_pool example/thread_pool.cpp
 
+#include <atomic>
 #include <vector>
 #include <iostream>
 #include <thread_pool.hpp>
 
 using namespace monster;
 
+task<int> square(thread_pool& pools, int n)
+{
+    // resume on a worker of the pool
+    co_await pools.schedule();
+
+    co_return n * n;
+}
+
+task<int> sum_of_squares(thread_pool& pools)
+{
+    // fan out, each spawned task runs on its own worker
+    auto a = spawn(pools, square(pools, 3));
+    auto b = spawn(pools, square(pools, 4));
+
+    // fan in, a suspended coroutine holds no thread
+    co_return co_await a + co_await b;
+}
+
 int main(int argc, char* argv[])
 {
     thread_pool pools(4);
@@ -36,5 +55,138 @@ int main(int argc, char* argv[])
 
     std::cout << std::endl;
 
+    // tasks posted from a worker stay on its own deque, idle workers steal them
+    basic_thread_pool<work_stealing> stealing(4);
+
+    auto sum = stealing.post([&stealing]
+    {
+        std::vector<std::future<int>> parts;
+
+        for (int i = 0; i != 16; ++i)
+             parts.emplace_back(stealing.post([i]{ return i * i; }));
+
+        int n = 0;
+
+        for (auto&& part : parts)
+             n += part.get();
+
+        return n;
+    });
+
+    std::cout << sum.get() << std::endl;
+
+    // small callables are stored in place and the future state is recycled, no allocation per task
+    std::vector<task_future<int>> futures;
+
+    for (int i = 0; i != 16; ++i)
+         futures.emplace_back(pools.submit([](int n){ return n * n; }, i));
+
+    for (auto&& future : futures)
+         std::cout << future.get() << " ";
+
+    std::cout << std::endl;
+
+    // a whole batch is enqueued under one lock, the handle completes when every index is done
+    std::vector<int> squares(64);
+
+    pools.parallel_for(0, 64, 8, [&](int i){ squares[i] = i * i; }).get();
+
+    std::cout << squares.back() << std::endl;
+
+    // fire and forget, wait_idle returns once every task posted so far has finished
+    std::atomic<int> counter = 0;
+
+    for (int i = 0; i != 16; ++i)
+         pools.execute([&counter]{ ++counter; });
+
+    pools.wait_idle();
+
+    std::cout << counter << std::endl;
+
+    // many producers post concurrently without a lock, idle workers park on an atomic
+    basic_thread_pool<lock_free_queue<256>> lock_free(4);
+
+    std::cout << lock_free.submit([]{ return 42; }).get() << std::endl;
+
+    // lane 0 is drained first, tasks waiting longer than the aging limit are served regardless
+    basic_thread_pool<priority_lanes<3>> lanes(4);
+
+    auto urgent = lanes.submit(priority{0}, []{ return 1; });
+    auto background = lanes.submit(priority{2}, []{ return 2; });
+
+    std::cout << urgent.get() + background.get() << " " << lanes.queue().size(2) << std::endl;
+
+    // workers grouped by NUMA node and pinned to its cpus, node local tasks stay on that node
+    basic_thread_pool<work_stealing> numa({ .size = 4, .numa = true });
+
+    std::cout << numa.submit(numa_node{0}, []{ return 0; }).get() << " " << numa.nodes() << std::endl;
+
+    // workers are started on demand up to size, and those above min exit after keep_alive without work
+    thread_pool elastic({ .size = 4, .min = 0, .keep_alive = std::chrono::milliseconds(10), .spin = 100, .yield = 10 });
+
+    std::cout << elastic.submit([]{ return 1; }).get() << " " << elastic.size() << std::endl;
+
+    // continuations are scheduled when their input completes, no thread blocks in between
+    auto chained = pools.submit([]{ return 20; }).then(pools, [](int n){ return n + 1; });
+    auto both = when_all(std::move(chained), pools.submit([]{ return 2; }));
+
+    auto [lhs, rhs] = both.get();
+    std::cout << lhs.get() * rhs.get() << std::endl;
+
+    // a node runs once all of its predecessors have finished
+    task_graph graph;
+    std::vector<int> values(4);
+
+    auto a = graph.emplace([&]{ values[0] = 1; });
+    auto b = graph.emplace([&]{ values[1] = values[0] + 1; });
+    auto c = graph.emplace([&]{ values[2] = values[0] + 2; });
+    auto d = graph.emplace([&]{ values[3] = values[1] * values[2]; });
+
+    graph.precede(a, b);
+    graph.precede(a, c);
+
+    graph.precede(b, d);
+    graph.precede(c, d);
+
+    graph.run(pools).get();
+
+    std::cout << values[3] << std::endl;
+
+    std::cout << spawn(pools, sum_of_squares(pools)).get() << std::endl;
+
+    // a task taking a std::stop_token is handed the pool's token, abort drops what has not started
+    thread_pool cancel(1);
+
+    auto loop = cancel.submit([](std::stop_token token)
+    {
+        int n = 0;
+
+        while (!token.stop_requested())
+        {
+            ++n;
+            std::this_thread::yield();
+        }
+
+        return n > 0;
+    });
+
+    auto dropped = cancel.submit([]{ return 0; });
+    cancel.shutdown_for(std::chrono::milliseconds(10));
+
+    try
+    {
+        dropped.get();
+    }
+    catch (const std::future_error& e)
+    {
+        std::cout << loop.get() << " " << e.what() << std::endl;
+    }
+
+    pools.wait_idle();
+
+    // the counters beyond workers, queued and active need -DMONSTER_THREAD_POOL_STATISTICS
+    auto stats = pools.snapshot();
+    std::cout << stats.workers << " " << stats.queued << " " << stats.active << std::endl;
+
     return 0;
 }
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+// g++ -I include -m64 -std=c++23 -s -Wall -O3 -l pthread -o /tmp/thread_pool_allocations example/thread_pool_allocations.cpp
+
+#include <new>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <thread_pool.hpp>
+
+using namespace monster;
+
+// every heap allocation of the process, from any thread, goes through here
+
+std::atomic<size_t> allocations = 0;
+
+void* operator new(size_t n)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto p = std::malloc(n ? n : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// submit, task_future::get and execute allocate nothing once the task slots and queues are warm
+
+template <typename Queue>
+bool steady_state(const char* name)
+{
+    basic_thread_pool<Queue> pools(4);
+
+    auto one_by_one = [&]
+    {
+        for (int i = 0; i != 10000; ++i)
+             pools.submit([](int n){ return n * n; }, i).get();
+    };
+
+    std::vector<task_future<int>> futures;
+    futures.reserve(1000);
+
+    auto burst = [&]
+    {
+        for (int i = 0; i != 1000; ++i)
+             futures.push_back(pools.submit([](int n){ return n; }, i));
+
+        for (auto& f : futures)
+             f.get();
+
+        futures.clear();
+    };
+
+    auto fire_and_forget = [&]
+    {
+        for (int i = 0; i != 10000; ++i)
+             pools.execute([]{});
+
+        pools.wait_idle();
+    };
+
+    one_by_one();
+    burst();
+    burst();
+
+    // hold every worker while warming up, so the queues grow to the deepest backlog the measured run can see
+
+    std::atomic<bool> hold = true;
+    std::atomic<int> held = 0;
+
+    for (int i = 0; i != 4; ++i)
+    {
+         pools.execute([&]
+         {
+             held.fetch_add(1);
+
+             while (hold.load())
+                  std::this_thread::yield();
+         });
+    }
+
+    while (held.load() != 4)
+         std::this_thread::yield();
+
+    for (int i = 0; i != 10000; ++i)
+         pools.execute([]{});
+
+    hold.store(false);
+    pools.wait_idle();
+
+    auto count = [](auto&& f)
+    {
+        auto before = allocations.load();
+        f();
+
+        return allocations.load() - before;
+    };
+
+    auto a = count(one_by_one);
+    auto b = count(burst);
+    auto c = count(fire_and_forget);
+
+    std::cout << name << ": submit/get " << a << ", burst " << b << ", execute " << c << " allocations" << std::endl;
+
+    return a == 0 && b == 0 && c == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    bool ok = steady_state<fifo_queue>("fifo_queue");
+
+    ok &= steady_state<work_stealing>("work_stealing");
+    ok &= steady_state<lock_free_queue<1024>>("lock_free_queue");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+// g++ -I include -m64 -std=c++23 -s -Wall -O3 -l pthread -o /tmp/thread_pool_benchmark example/thread_pool_benchmark.cpp
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <thread_pool.hpp>
+
+using namespace monster;
+
+constexpr size_t tasks = 400000;
+
+// throughput of short tasks in million tasks per second
+
+template <typename F>
+double measure(F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return tasks / elapsed.count() / 1e6;
+}
+
+// one thread outside the pool posts every task
+
+template <typename Queue>
+double external(size_t workers)
+{
+    basic_thread_pool<Queue> pools(workers);
+    std::atomic<size_t> done = 0;
+
+    return measure([&]
+    {
+        for (size_t i = 0; i != tasks; ++i)
+             pools.execute([&done]{ done.fetch_add(1, std::memory_order_relaxed); });
+
+        pools.wait_idle();
+    });
+}
+
+// every worker posts its share of the tasks from inside the pool, the case a per worker deque is made for
+
+template <typename Queue>
+double nested(size_t workers)
+{
+    basic_thread_pool<Queue> pools(workers);
+    std::atomic<size_t> done = 0;
+
+    return measure([&]
+    {
+        for (size_t w = 0; w != workers; ++w)
+        {
+             pools.execute([&, share = tasks / workers + (w < tasks % workers)]
+             {
+                 for (size_t i = 0; i != share; ++i)
+                      pools.execute([&done]{ done.fetch_add(1, std::memory_order_relaxed); });
+             });
+        }
+
+        pools.wait_idle();
+    });
+}
+
+int main(int argc, char* argv[])
+{
+    size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+
+    for (size_t workers = 2; workers <= 4 * cores; workers *= 2)
+    {
+         std::cout << workers << " workers external: fifo_queue " << external<fifo_queue>(workers)
+                   << " M/s, work_stealing " << external<work_stealing>(workers) << " M/s" << std::endl;
+
+         std::cout << workers << " workers nested: fifo_queue " << nested<fifo_queue>(workers)
+                   << " M/s, work_stealing " << nested<work_stealing>(workers) << " M/s" << std::endl;
+    }
+
+    return 0;
+}
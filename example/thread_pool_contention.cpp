@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+// g++ -I include -m64 -std=c++23 -s -Wall -O3 -l pthread -o /tmp/thread_pool_contention example/thread_pool_contention.cpp
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <iomanip>
+#include <iostream>
+#include <thread_pool.hpp>
+
+using namespace monster;
+
+constexpr size_t tasks = 200000;
+
+// producers outside the pool post concurrently into a pool of consumers workers, in million tasks per second
+
+template <typename Queue>
+double sweep(size_t producers, size_t consumers)
+{
+    basic_thread_pool<Queue> pools(consumers);
+
+    std::atomic<size_t> done = 0;
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t p = 0; p != producers; ++p)
+    {
+         threads.emplace_back([&, share = tasks / producers + (p < tasks % producers)]
+         {
+             for (size_t i = 0; i != share; ++i)
+                  pools.execute([&done]{ done.fetch_add(1, std::memory_order_relaxed); });
+         });
+    }
+
+    for (auto& t : threads)
+         t.join();
+
+    pools.wait_idle();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return tasks / elapsed.count() / 1e6;
+}
+
+template <typename Queue>
+void table(const char* name, const std::vector<size_t>& counts)
+{
+    std::cout << name << ", producers down, consumers across" << std::endl << std::setw(4) << "";
+
+    for (auto c : counts)
+         std::cout << std::setw(8) << c;
+
+    std::cout << std::endl << std::fixed << std::setprecision(2);
+
+    for (auto p : counts)
+    {
+         std::cout << std::setw(4) << p;
+
+         for (auto c : counts)
+              std::cout << std::setw(8) << sweep<Queue>(p, c);
+
+         std::cout << std::endl;
+    }
+
+    std::cout << std::defaultfloat << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<size_t> counts;
+
+    for (size_t n = 1; n <= 2 * std::max<size_t>(std::thread::hardware_concurrency(), 2); n *= 2)
+         counts.push_back(n);
+
+    table<fifo_queue>("fifo_queue", counts);
+    table<work_stealing>("work_stealing", counts);
+    table<lock_free_queue<4096>>("lock_free_queue", counts);
+
+    return 0;
+}
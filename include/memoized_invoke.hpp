@@ -11,30 +11,559 @@
 #define MEMOIZED_INVOKE_HPP
 
 #include <map>
+#include <tuple>
+#include <bit>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <utility>
+#include <functional>
+#include <string_view>
+#include <type_traits>
 #include <monster.hpp>
 
+// The table of a memoized function is selected by a template parameter, both backends look a call up
+// by its arguments as passed, so a call with a std::string_view finds a std::string key without building
+// one, a key is only materialized on a miss and the function is then invoked with it.
+// A hashed_table bounded by an eviction policy holds at most the capacity passed to memoized_invoke,
+// the policies keep their bookkeeping in arrays indexed by entry, so every hit and eviction is O(1).
+
 namespace monster
 {
-    template <typename F>
-    constexpr decltype(auto) memoized_invoke(F&& f)
+    // a std::map with transparent comparison, one lower_bound finds the entry or the hint to insert at
+
+    template <typename Key, typename Value>
+    class ordered_table
+    {
+        public:
+            template <typename Tuple, typename F>
+            Value find_or_insert(Tuple&& args, F& f)
+            {
+                auto it = table.lower_bound(args);
+
+                if (it != table.end() && !(args < it->first))
+                {
+                    ++hits;
+
+                    return it->second;
+                }
+
+                ++misses;
+
+                Key key(std::forward<Tuple>(args));
+                auto result = std::apply(f, key);
+
+                table.emplace_hint(it, std::move(key), result);
+
+                return result;
+            }
+
+            size_t size() const noexcept
+            {
+                return table.size();
+            }
+
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+
+        private:
+            std::map<Key, Value, std::less<>> table;
+    };
+
+    // hashes a tuple element by element, string-like elements as std::string_view, so any
+    // argument convertible to std::string_view hashes the same as the key it is compared with
+
+    template <typename Key>
+    struct tuple_hash
     {
-        std::map<function_traits_t<F>, function_traits_r<F>> table;
+        template <typename Tuple>
+        size_t operator()(const Tuple& t) const
+        {
+            return [&]<size_t... I>(std::index_sequence<I...>)
+            {
+                size_t seed = 0;
+                ((seed ^= element<std::tuple_element_t<I, Key>>(std::get<I>(t)) + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2)), ...);
+
+                return seed;
+            }(std::make_index_sequence<std::tuple_size_v<Key>>());
+        }
 
-        return [=]<typename... Args>(Args&&... args) mutable
+        template <typename K, typename U>
+        static size_t element(const U& u)
         {
-            auto tuple = std::forward_as_tuple(std::forward<Args>(args)...);
-            auto cache = table.find(tuple);
+            if constexpr (std::is_convertible_v<const K&, std::string_view>)
+                return std::hash<std::string_view>()(u);
+            else
+                return std::hash<K>()(u);
+        }
+    };
+
+    // keeps every entry, the table grows instead of evicting
+
+    struct unbounded
+    {
+        static constexpr bool bounded = false;
+
+        void insert(uint32_t) noexcept
+        {
+        }
+
+        void touch(uint32_t) noexcept
+        {
+        }
+    };
+
+    // evicts the least recently used entry, a circular list through the entries with a sentinel at capacity
+
+    class lru_policy
+    {
+        public:
+            static constexpr bool bounded = true;
+
+            explicit lru_policy(size_t capacity) : links(capacity + 1), sentinel(capacity)
+            {
+                links[sentinel] = { sentinel, sentinel };
+            }
+
+            void insert(uint32_t e) noexcept
+            {
+                link(e);
+            }
+
+            void touch(uint32_t e) noexcept
+            {
+                unlink(e);
+                link(e);
+            }
+
+            uint32_t victim() noexcept
+            {
+                auto e = links[sentinel].prev;
+                unlink(e);
+
+                return e;
+            }
+
+        private:
+            struct link_type
+            {
+                uint32_t prev;
+                uint32_t next;
+            };
+
+            void link(uint32_t e) noexcept
+            {
+                auto next = links[sentinel].next;
+
+                links[e] = { sentinel, next };
+                links[next].prev = links[sentinel].next = e;
+            }
 
-            if (cache == table.end())
+            void unlink(uint32_t e) noexcept
             {
-                auto result = std::apply(f, tuple);
-                table[tuple] = result;
+                auto [prev, next] = links[e];
+
+                links[prev].next = next;
+                links[next].prev = prev;
+            }
+
+            std::vector<link_type> links;
+            uint32_t sentinel;
+    };
+
+    // evicts the least frequently used entry, the oldest among equals, entries sit in circular lists hung off
+    // buckets of equal count, the buckets form an ascending circular list with a sentinel of count zero at 0,
+    // a touch adds the next bucket before it may free the current one, hence one bucket more than entries
+
+    class lfu_policy
+    {
+        public:
+            static constexpr bool bounded = true;
+
+            explicit lfu_policy(size_t capacity) : nodes(capacity), buckets(capacity + 2)
+            {
+                buckets[0] = { 0, none, 0, 0 };
+
+                for (uint32_t b = 1; b != buckets.size(); ++b)
+                     buckets[b].next = b + 1 == buckets.size() ? none : b + 1;
+
+                spare = 1;
+            }
+
+            void insert(uint32_t e) noexcept
+            {
+                auto b = buckets[0].next;
+
+                if (b == 0 || buckets[b].count != 1)
+                    b = add(0, 1);
+
+                push(b, e);
+            }
+
+            void touch(uint32_t e) noexcept
+            {
+                auto b = nodes[e].bucket;
+                auto n = buckets[b].next;
+
+                if (n == 0 || buckets[n].count != buckets[b].count + 1)
+                    n = add(b, buckets[b].count + 1);
+
+                pop(b, e);
+                push(n, e);
+            }
+
+            uint32_t victim() noexcept
+            {
+                auto b = buckets[0].next;
+                auto e = nodes[buckets[b].first].prev;
+
+                pop(b, e);
+
+                return e;
+            }
+
+        private:
+            static constexpr uint32_t none = UINT32_MAX;
+
+            struct node
+            {
+                uint32_t prev;
+                uint32_t next;
+                uint32_t bucket;
+            };
+
+            struct bucket
+            {
+                uint64_t count;
+                uint32_t first;
+
+                uint32_t prev;
+                uint32_t next;
+            };
+
+            uint32_t add(uint32_t after, uint64_t count) noexcept
+            {
+                auto b = std::exchange(spare, buckets[spare].next);
+                auto next = buckets[after].next;
+
+                buckets[b] = { count, none, after, next };
+                buckets[next].prev = buckets[after].next = b;
+
+                return b;
+            }
+
+            void push(uint32_t b, uint32_t e) noexcept
+            {
+                auto first = buckets[b].first;
+
+                if (first == none)
+                    nodes[e] = { e, e, b };
+                else
+                {
+                    auto last = nodes[first].prev;
+
+                    nodes[e] = { last, first, b };
+                    nodes[last].next = nodes[first].prev = e;
+                }
+
+                buckets[b].first = e;
+            }
+
+            void pop(uint32_t b, uint32_t e) noexcept
+            {
+                auto [prev, next, _] = nodes[e];
+
+                if (next == e)
+                {
+                    auto before = buckets[b].prev;
+                    auto after = buckets[b].next;
+
+                    buckets[before].next = after;
+                    buckets[after].prev = before;
+
+                    buckets[b].next = std::exchange(spare, b);
+                }
+                else
+                {
+                    nodes[prev].next = next;
+                    nodes[next].prev = prev;
+
+                    if (buckets[b].first == e)
+                        buckets[b].first = next;
+                }
+            }
+
+            std::vector<node> nodes;
+            std::vector<bucket> buckets;
+
+            uint32_t spare;
+    };
+
+    // approximates lru with a reference bit per entry, the hand clears bits until it finds an entry not used since its last pass
+
+    class clock_policy
+    {
+        public:
+            static constexpr bool bounded = true;
+
+            explicit clock_policy(size_t capacity) : referenced(capacity)
+            {
+            }
+
+            void insert(uint32_t e) noexcept
+            {
+                referenced[e] = true;
+            }
+
+            void touch(uint32_t e) noexcept
+            {
+                referenced[e] = true;
+            }
+
+            uint32_t victim() noexcept
+            {
+                while (referenced[hand])
+                {
+                    referenced[hand] = false;
+                    advance();
+                }
+
+                auto e = hand;
+                advance();
+
+                return e;
+            }
+
+        private:
+            void advance() noexcept
+            {
+                if (++hand == referenced.size())
+                    hand = 0;
+            }
+
+            std::vector<uint8_t> referenced;
+            uint32_t hand = 0;
+    };
+
+    // open addressing with linear probing over slots of a hash tag and an entry index, the entries are
+    // kept densely, a miss remembers the empty slot it stopped at and fills it without a second probe
+    // unless the function reentered the table while it ran, a full bounded table reuses the entry of
+    // the victim its policy picks and closes the gap left in the probe sequence by shifting slots back
+
+    template <typename Key, typename Value, typename Policy = unbounded, typename Hash = tuple_hash<Key>>
+    class hashed_table
+    {
+        public:
+            hashed_table() requires (!Policy::bounded) : slots(16), shift(60)
+            {
+            }
+
+            explicit hashed_table(size_t capacity) requires Policy::bounded : policy(std::max<size_t>(capacity, 1)),
+            slots(std::bit_ceil(std::max<size_t>(capacity, 1) * 4 / 3 + 1)), shift(64 - std::countr_zero(slots.size())), capacity(std::max<size_t>(capacity, 1))
+            {
+                entries.reserve(this->capacity);
+            }
+
+            template <typename Tuple, typename F>
+            Value find_or_insert(Tuple&& args, F& f)
+            {
+                auto h = mix(hash(args));
+                auto [i, found] = probe(h, args);
+
+                if (found)
+                {
+                    ++hits;
+                    policy.touch(slots[i].entry);
+
+                    return entries[slots[i].entry].second;
+                }
+
+                ++misses;
+
+                Key key(std::forward<Tuple>(args));
+
+                auto version = inserts;
+                auto result = std::apply(f, key);
+
+                uint32_t e = entries.size();
+
+                if constexpr (Policy::bounded)
+                {
+                    if (e == capacity)
+                    {
+                        e = policy.victim();
+                        erase(e);
+
+                        entries[e] = { std::move(key), result };
+                        i = probe(h, entries[e].first).first;
+                    }
+                }
+
+                if (e == entries.size())
+                {
+                    if (!Policy::bounded && (entries.size() + 1) * 4 > slots.size() * 3)
+                    {
+                        grow();
+                        i = probe(h, key).first;
+                    }
+                    else if (inserts != version)
+                        i = probe(h, key).first;
+
+                    entries.emplace_back(std::move(key), result);
+                }
+
+                slots[i] = { uint32_t(h >> 32), e };
+
+                policy.insert(e);
+                ++inserts;
 
                 return result;
             }
 
-            return cache->second;
-        };
+            size_t size() const noexcept
+            {
+                return entries.size();
+            }
+
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+
+        private:
+            static constexpr uint32_t vacant = UINT32_MAX;
+
+            // the tag is the top half of the hash, the home slot is the top bits of the tag
+
+            struct slot
+            {
+                uint32_t tag = 0;
+                uint32_t entry = vacant;
+            };
+
+            static size_t mix(size_t h) noexcept
+            {
+                return h * 0x9e3779b97f4a7c15;
+            }
+
+            template <typename Tuple>
+            std::pair<size_t, bool> probe(size_t h, const Tuple& args) const
+            {
+                for (size_t mask = slots.size() - 1, i = h >> shift; ; i = (i + 1) & mask)
+                {
+                     auto& s = slots[i];
+
+                     if (s.entry == vacant)
+                         return { i, false };
+
+                     if (s.tag == uint32_t(h >> 32) && entries[s.entry].first == args)
+                         return { i, true };
+                }
+            }
+
+            void erase(uint32_t e)
+            {
+                auto mask = slots.size() - 1;
+                auto j = mix(hash(entries[e].first)) >> shift;
+
+                while (slots[j].entry != e)
+                     j = (j + 1) & mask;
+
+                for (auto k = (j + 1) & mask; slots[k].entry != vacant; k = (k + 1) & mask)
+                {
+                     auto home = slots[k].tag >> (shift - 32);
+
+                     if (((k - home) & mask) >= ((k - j) & mask))
+                     {
+                         slots[j] = slots[k];
+                         j = k;
+                     }
+                }
+
+                slots[j] = {};
+            }
+
+            void grow()
+            {
+                slots.assign(slots.size() * 2, {});
+                --shift;
+
+                for (size_t mask = slots.size() - 1, e = 0; e != entries.size(); ++e)
+                {
+                     auto h = mix(hash(entries[e].first));
+                     auto i = h >> shift;
+
+                     while (slots[i].entry != vacant)
+                          i = (i + 1) & mask;
+
+                     slots[i] = { uint32_t(h >> 32), uint32_t(e) };
+                }
+            }
+
+            [[no_unique_address]] Hash hash;
+            [[no_unique_address]] Policy policy;
+
+            std::vector<slot> slots;
+            std::vector<std::pair<Key, Value>> entries;
+
+            int shift;
+            size_t capacity = std::numeric_limits<uint32_t>::max();
+
+            uint64_t inserts = 0;
+    };
+
+    template <typename Key, typename Value>
+    using lru_table = hashed_table<Key, Value, lru_policy>;
+
+    template <typename Key, typename Value>
+    using lfu_table = hashed_table<Key, Value, lfu_policy>;
+
+    template <typename Key, typename Value>
+    using clock_table = hashed_table<Key, Value, clock_policy>;
+
+    // a memoized function, copies memoize independently, the counters tell how well the table fits the calls
+
+    template <typename F, typename Table>
+    class memoized
+    {
+        public:
+            template <typename... Args>
+            memoized(F f, Args&&... args) : f(std::move(f)), table(std::forward<Args>(args)...)
+            {
+            }
+
+            template <typename... Args>
+            decltype(auto) operator()(Args&&... args)
+            {
+                return table.find_or_insert(std::forward_as_tuple(std::forward<Args>(args)...), f);
+            }
+
+            uint64_t hits() const noexcept
+            {
+                return table.hits;
+            }
+
+            uint64_t misses() const noexcept
+            {
+                return table.misses;
+            }
+
+            size_t size() const noexcept
+            {
+                return table.size();
+            }
+
+        private:
+            F f;
+            Table table;
+    };
+
+    // the arguments after f construct the table, a bounded table takes its capacity
+
+    template <template <typename, typename> typename Table = ordered_table, typename F, typename... Args>
+    constexpr decltype(auto) memoized_invoke(F&& f, Args&&... args)
+    {
+        using type = std::decay_t<F>;
+
+        return memoized<type, Table<function_traits_t<type>, function_traits_r<type>>>(std::forward<F>(f), std::forward<Args>(args)...);
     }
 }
 
@@ -10,20 +10,241 @@
 #ifndef OBJECT_POOL_HPP
 #define OBJECT_POOL_HPP
 
-#include <queue>
+#include <bit>
+#include <deque>
+#include <mutex>
+#include <tuple>
+#include <thread>
+#include <vector>
+#include <limits>
+#include <atomic>
 #include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <memory_resource>
 
 // An object pool that can be used with any class that provides a default constructor.
+// It may be shared between threads, each thread keeps its free objects in two magazines
+// of its own and trades whole magazines with a lock-free depot only when they run full or empty.
+// Besides the shared_ptr of allocate, a move-only unique_type and an intrusively counted intrusive_type
+// return the object to the pool without allocating a control block.
+// With a non-zero Slab, objects are constructed in contiguous slabs of Slab slots instead of one heap
+// allocation each, slots not holding an object are threaded into an intrusive free list.
+// The depot keeps at most limit objects, reserve constructs objects ahead of demand and trim destroys
+// the ones parked in the depot and frees the slabs left without an object, a reset hook runs on every release and may refuse to pool the object.
+// Handles may outlive the pool, the pool's state then lives on until the last of them is released.
+// A pool_resource serves std::pmr containers from slab pools of power of two size classes.
 
 namespace monster
 {
-    template <typename T>
+    // a point in time view of a pool, live counts the objects constructed and not yet destroyed,
+    // whether free or handed out, high_water is the most that were ever live at once
+
+    struct object_pool_statistics
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+
+        size_t outstanding = 0;
+        size_t retained = 0;
+
+        size_t live = 0;
+        size_t high_water = 0;
+    };
+
+    class pool_resource;
+
+    template <typename T, size_t Slab = 0>
     class object_pool
     {
+            friend class pool_resource;
+
+            struct node;
+            struct depot;
+
         public:
+            class unique_handle;
+            class intrusive_handle;
+
             using type = std::shared_ptr<T>;
 
-            object_pool() = default;
+            using unique_type = unique_handle;
+            using intrusive_type = intrusive_handle;
+
+            static constexpr size_t magazine_size = 32;
+
+            // owns one pooled object, moving transfers it, destruction or reset hands it back to the pool
+
+            class unique_handle
+            {
+                public:
+                    unique_handle() = default;
+
+                    unique_handle(unique_handle&& other) noexcept : n(std::exchange(other.n, nullptr)), d(std::exchange(other.d, nullptr))
+                    {
+                    }
+
+                    unique_handle& operator=(unique_handle&& other) noexcept
+                    {
+                        if (this != &other)
+                        {
+                            reset();
+
+                            n = std::exchange(other.n, nullptr);
+                            d = std::exchange(other.d, nullptr);
+                        }
+
+                        return *this;
+                    }
+
+                    T* get() const noexcept
+                    {
+                        return n ? &n->value : nullptr;
+                    }
+
+                    T& operator*() const noexcept
+                    {
+                        return n->value;
+                    }
+
+                    T* operator->() const noexcept
+                    {
+                        return &n->value;
+                    }
+
+                    explicit operator bool() const noexcept
+                    {
+                        return n;
+                    }
+
+                    void reset() noexcept
+                    {
+                        if (n)
+                            d->release(std::exchange(n, nullptr));
+                    }
+
+                    ~unique_handle()
+                    {
+                        reset();
+                    }
+
+                private:
+                    friend class object_pool;
+                    friend class intrusive_handle;
+
+                    unique_handle(node* n, depot* d) noexcept : n(n), d(d)
+                    {
+                    }
+
+                    node* n = nullptr;
+                    depot* d = nullptr;
+            };
+
+            // shares one pooled object, the count lives next to the object, the last copy hands it back to the pool
+
+            class intrusive_handle
+            {
+                public:
+                    intrusive_handle() = default;
+
+                    intrusive_handle(const intrusive_handle& other) noexcept : n(other.n), d(other.d)
+                    {
+                        if (n)
+                            n->refs.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    intrusive_handle(intrusive_handle&& other) noexcept : n(std::exchange(other.n, nullptr)), d(std::exchange(other.d, nullptr))
+                    {
+                    }
+
+                    intrusive_handle(unique_handle&& other) noexcept : intrusive_handle(std::exchange(other.n, nullptr), std::exchange(other.d, nullptr))
+                    {
+                    }
+
+                    intrusive_handle& operator=(intrusive_handle other) noexcept
+                    {
+                        std::swap(n, other.n);
+                        std::swap(d, other.d);
+
+                        return *this;
+                    }
+
+                    T* get() const noexcept
+                    {
+                        return n ? &n->value : nullptr;
+                    }
+
+                    T& operator*() const noexcept
+                    {
+                        return n->value;
+                    }
+
+                    T* operator->() const noexcept
+                    {
+                        return &n->value;
+                    }
+
+                    explicit operator bool() const noexcept
+                    {
+                        return n;
+                    }
+
+                    size_t use_count() const noexcept
+                    {
+                        return n ? n->refs.load(std::memory_order_relaxed) : 0;
+                    }
+
+                    void reset() noexcept
+                    {
+                        if (n && n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                            d->release(n);
+
+                        n = nullptr;
+                    }
+
+                    ~intrusive_handle()
+                    {
+                        reset();
+                    }
+
+                private:
+                    friend class object_pool;
+
+                    intrusive_handle(node* n, depot* d) noexcept : n(n), d(d)
+                    {
+                        if (n)
+                            n->refs.store(1, std::memory_order_relaxed);
+                    }
+
+                    node* n = nullptr;
+                    depot* d = nullptr;
+            };
+
+            object_pool() : object_pool(std::numeric_limits<size_t>::max())
+            {
+            }
+
+            // each thread caches up to two magazines of its own on top of the limit held in the depot
+
+            explicit object_pool(size_t limit) : core(std::make_shared<depot>(limit))
+            {
+            }
+
+            // the hook runs on the releasing thread and must not throw, one returning bool destroys the object on false
+
+            template <typename F>
+            requires std::is_invocable_v<F&, T&>
+            object_pool(size_t limit, F&& f) : object_pool(limit)
+            {
+                if constexpr (std::is_void_v<std::invoke_result_t<F&, T&>>)
+                    core->reset = [f = std::forward<F>(f)](T& t) mutable { f(t); return true; };
+                else
+                    core->reset = std::forward<F>(f);
+            }
 
             object_pool(const object_pool&) = delete;
             object_pool& operator=(const object_pool&) = delete;
@@ -33,28 +254,806 @@ namespace monster
 
             type allocate()
             {
-                if (objects.empty())
-                    objects.emplace(std::make_unique<T>());
-
-                std::unique_ptr<T> obj(std::move(objects.front()));
-                objects.pop();
+                auto n = core->acquire();
 
-                type dst(obj.release(), [this](T* t)
+                type dst(&n->value, [core = core.get(), n](T*)
                 {
-                    objects.emplace(t);
+                    core->release(n);
                 });
 
                 return dst;
             }
 
-            virtual ~object_pool() = default;
+            unique_type allocate_unique()
+            {
+                return unique_type(core->acquire(), core.get());
+            }
+
+            intrusive_type allocate_intrusive()
+            {
+                return intrusive_type(core->acquire(), core.get());
+            }
+
+            // constructs up to n objects into the depot, as far as the limit allows
+
+            void reserve(size_t n)
+            {
+                for (size_t stored; n && (stored = core->stored.load(std::memory_order_relaxed)) < core->limit; )
+                {
+                    auto m = core->make();
+                    auto room = std::min(core->limit - stored, magazine_size);
+
+                    try
+                    {
+                        for (; n && m->count != room; --n)
+                             m->objects[m->count++] = core->create();
+                    }
+                    catch (...)
+                    {
+                        core->park(m);
+                        throw;
+                    }
+
+                    core->park(m);
+                }
+            }
+
+            // destroys objects parked in the depot until at most keep remain, a magazine that straddles keep is parked again with the rest,
+            // in slab mode every slab whose slots are all free again is then handed back
+
+            void trim(size_t keep = 0)
+            {
+                while (core->stored.load(std::memory_order_relaxed) > keep)
+                {
+                    auto m = core->unpark();
+
+                    if (!m)
+                        break;
+
+                    auto rest = core->stored.load(std::memory_order_relaxed);
+                    auto fit = rest < keep ? std::min(m->count, keep - rest) : 0;
+
+                    while (m->count != fit)
+                         core->destroy(m->objects[--m->count]);
+
+                    core->park(m);
+                }
+
+                if constexpr (Slab != 0)
+                    core->shed();
+            }
+
+            object_pool_statistics snapshot() const
+            {
+                return core->snapshot();
+            }
+
+            virtual ~object_pool()
+            {
+                core->close();
+            }
+
+        private:
+            struct node
+            {
+                T value;
+                std::atomic<size_t> refs = 0;
+            };
+
+            union slot
+            {
+                slot* next;
+                alignas(node) std::byte storage[sizeof(node)];
+            };
+
+            struct magazine
+            {
+                node* objects[magazine_size];
+                size_t count = 0;
+
+                std::atomic<magazine*> next = nullptr;
+                magazine* link = nullptr;
+            };
+
+            // a stack of magazines, the head packs a pointer with a 16 bit tag in the bits above the
+            // 48 bit user address space, so a head popped and pushed back in between fails the cas
+
+            class stack
+            {
+                static_assert(sizeof(void*) == 8, "the tag is packed above a 48 bit address");
+
+                public:
+                    void push(magazine* m) noexcept
+                    {
+                        auto old = head.load(std::memory_order_relaxed);
+
+                        do
+                        {
+                            m->next.store(pointer(old), std::memory_order_relaxed);
+                        }
+                        while (!head.compare_exchange_weak(old, pack(m, old), std::memory_order_release, std::memory_order_relaxed));
+                    }
+
+                    magazine* pop() noexcept
+                    {
+                        auto old = head.load(std::memory_order_acquire);
+
+                        while (auto m = pointer(old))
+                        {
+                            if (head.compare_exchange_weak(old, pack(m->next.load(std::memory_order_relaxed), old), std::memory_order_acquire, std::memory_order_acquire))
+                                return m;
+                        }
+
+                        return nullptr;
+                    }
+
+                private:
+                    static magazine* pointer(uint64_t v) noexcept
+                    {
+                        return reinterpret_cast<magazine*>(v & ((uint64_t(1) << 48) - 1));
+                    }
+
+                    static uint64_t pack(magazine* m, uint64_t old) noexcept
+                    {
+                        return reinterpret_cast<uint64_t>(m) | ((old >> 48) + 1) << 48;
+                    }
+
+                    alignas(64) std::atomic<uint64_t> head{0};
+            };
+
+            // the counters are written by the owning thread only, so they need no read-modify-write,
+            // active brackets a release so that close can tell when none is between its check and its count
+
+            struct alignas(64) cache
+            {
+                magazine* loaded = nullptr;
+                magazine* previous = nullptr;
+
+                std::atomic<size_t> hits = 0;
+                std::atomic<size_t> misses = 0;
+                std::atomic<size_t> released = 0;
+
+                std::atomic<bool> active = false;
+                bool vacant = false;
+            };
+
+            static void bump(std::atomic<size_t>& counter) noexcept
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+
+            // full magazines wait in the depot for a thread that runs empty, empty ones for a thread that runs full,
+            // every magazine ever made stays on the all list until the depot dies, so a stale pop reads valid memory
+
+            struct depot : std::enable_shared_from_this<depot>
+            {
+                node* acquire()
+                {
+                    if (exited)
+                    {
+                        auto n = create();
+
+                        std::lock_guard<std::mutex> lock(registering);
+                        bump(stray().misses);
+
+                        return n;
+                    }
+
+                    auto& c = local.find(this);
+
+                    if (c.loaded->count == 0)
+                    {
+                        if (c.previous->count != 0)
+                            std::swap(c.loaded, c.previous);
+                        else if (auto m = unpark())
+                        {
+                            empty.push(c.previous);
+
+                            c.previous = c.loaded;
+                            c.loaded = m;
+                        }
+                        else
+                        {
+                            auto n = create();
+                            bump(c.misses);
+
+                            return n;
+                        }
+                    }
+
+                    bump(c.hits);
+
+                    return c.loaded->objects[--c.loaded->count];
+                }
+
+                void release(node* n)
+                {
+                    if (exited)
+                        return orphan(n);
+
+                    auto& c = local.find(this);
+                    c.active.store(true, std::memory_order_seq_cst);
+
+                    if (closed.load(std::memory_order_seq_cst))
+                    {
+                        c.active.store(false, std::memory_order_release);
+
+                        return abandon(n);
+                    }
+
+                    stash(c, n);
+                    c.active.store(false, std::memory_order_release);
+                }
+
+                // a pool_resource is destroyed only after its blocks are all deallocated, so its releases never race close
+
+                void reclaim(node* n)
+                {
+                    if (exited)
+                        return orphan(n);
+
+                    stash(local.find(this), n);
+                }
+
+                void stash(cache& c, node* n)
+                {
+                    bump(c.released);
+
+                    if (reset && !reset(n->value))
+                        destroy(n);
+                    else
+                    {
+                        if (c.loaded->count == magazine_size)
+                        {
+                            if (c.previous->count == 0)
+                                std::swap(c.loaded, c.previous);
+                            else
+                            {
+                                park(c.previous);
+
+                                c.previous = c.loaded;
+                                c.loaded = make();
+                            }
+                        }
+
+                        c.loaded->objects[c.loaded->count++] = n;
+                    }
+                }
+
+                // a release after the pool is gone destroys the object, the last one takes the depot with it
+
+                void abandon(node* n) noexcept
+                {
+                    destroy(n);
+
+                    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        auto self = std::move(keep);
+                }
+
+                // a thread whose registry is already destroyed has no cache, its releases destroy the object and are
+                // counted in a shared cache under the lock, which close holds while it sums the counts
+
+                void orphan(node* n)
+                {
+                    std::unique_lock<std::mutex> lock(registering);
+
+                    if (closed.load(std::memory_order_seq_cst))
+                    {
+                        lock.unlock();
+
+                        return abandon(n);
+                    }
+
+                    bump(stray().released);
+                    destroy(n);
+                }
+
+                cache& stray()
+                {
+                    if (!strays)
+                        strays = &caches.emplace_back();
+
+                    return *strays;
+                }
+
+                // stops the fast path of release and counts the handles still out, the depot keeps itself alive for them
+
+                void close()
+                {
+                    closed.store(true, std::memory_order_seq_cst);
+
+                    int64_t out = 0;
+
+                    {
+                        std::lock_guard<std::mutex> lock(registering);
+
+                        for (auto& c : caches)
+                        {
+                             while (c.active.load(std::memory_order_seq_cst))
+                                  std::this_thread::yield();
+
+                             out += c.hits.load(std::memory_order_relaxed) + c.misses.load(std::memory_order_relaxed) - c.released.load(std::memory_order_relaxed);
+                        }
+                    }
+
+                    while (auto m = unpark())
+                    {
+                        clear(m);
+                        empty.push(m);
+                    }
+
+                    if (out)
+                    {
+                        keep = this->shared_from_this();
+
+                        if (remaining.fetch_add(out - bias, std::memory_order_acq_rel) + out - bias == 0)
+                            auto self = std::move(keep);
+                    }
+                }
+
+                object_pool_statistics snapshot()
+                {
+                    object_pool_statistics stats;
+
+                    size_t released = 0;
+                    std::lock_guard<std::mutex> lock(registering);
+
+                    for (auto& c : caches)
+                    {
+                         released += c.released.load(std::memory_order_acquire);
+
+                         stats.hits += c.hits.load(std::memory_order_relaxed);
+                         stats.misses += c.misses.load(std::memory_order_relaxed);
+                    }
+
+                    stats.outstanding = stats.hits + stats.misses > released ? stats.hits + stats.misses - released : 0;
+                    stats.retained = stored.load(std::memory_order_relaxed);
+
+                    stats.live = live.load(std::memory_order_relaxed);
+                    stats.high_water = high_water.load(std::memory_order_relaxed);
+
+                    return stats;
+                }
+
+                // a thread that touches the depot for the first time takes a cache, one left by an exited thread if there is
+
+                cache* attach()
+                {
+                    std::lock_guard<std::mutex> lock(registering);
+
+                    auto it = std::find_if(caches.begin(), caches.end(), [](auto& c){ return c.vacant; });
+                    auto& c = it != caches.end() ? *it : caches.emplace_back();
+
+                    c.loaded = make();
+                    c.previous = make();
+
+                    c.vacant = false;
+
+                    return &c;
+                }
+
+                // a thread that exits hands its magazines back
+
+                void detach(cache* c)
+                {
+                    park(std::exchange(c->loaded, nullptr));
+                    park(std::exchange(c->previous, nullptr));
+
+                    std::lock_guard<std::mutex> lock(registering);
+                    c->vacant = true;
+                }
+
+                magazine* make()
+                {
+                    if (auto m = empty.pop())
+                        return m;
+
+                    auto m = new (upstream->allocate(sizeof(magazine), alignof(magazine))) magazine;
+                    m->link = all.load(std::memory_order_relaxed);
+
+                    while (!all.compare_exchange_weak(m->link, m, std::memory_order_release, std::memory_order_relaxed));
+
+                    return m;
+                }
+
+                node* create()
+                {
+                    node* n;
+
+                    if constexpr (Slab == 0)
+                    {
+                        auto p = upstream->allocate(sizeof(node), alignof(node));
+
+                        try
+                        {
+                            n = new (p) node();
+                        }
+                        catch (...)
+                        {
+                            upstream->deallocate(p, sizeof(node), alignof(node));
+                            throw;
+                        }
+                    }
+                    else
+                    {
+                        auto s = carve();
+
+                        try
+                        {
+                            n = new (s->storage) node();
+                        }
+                        catch (...)
+                        {
+                            recycle(s);
+                            throw;
+                        }
+                    }
+
+                    auto now = live.fetch_add(1, std::memory_order_relaxed) + 1;
+
+                    for (auto high = high_water.load(std::memory_order_relaxed); high < now; )
+                    {
+                         if (high_water.compare_exchange_weak(high, now, std::memory_order_relaxed))
+                             break;
+                    }
+
+                    return n;
+                }
+
+                void destroy(node* n) noexcept
+                {
+                    live.fetch_sub(1, std::memory_order_relaxed);
+
+                    n->~node();
+
+                    if constexpr (Slab == 0)
+                        upstream->deallocate(n, sizeof(node), alignof(node));
+                    else
+                        recycle(reinterpret_cast<slot*>(n));
+                }
+
+                // a miss in slab mode takes the lowest free slot, a fresh slab is threaded in address order
+
+                slot* carve()
+                {
+                    std::lock_guard<std::mutex> lock(carving);
+
+                    if (!free)
+                    {
+                        auto slab = static_cast<slot*>(upstream->allocate(sizeof(slot) * Slab, alignof(slot)));
+
+                        try
+                        {
+                            slabs.push_back(slab);
+                        }
+                        catch (...)
+                        {
+                            upstream->deallocate(slab, sizeof(slot) * Slab, alignof(slot));
+                            throw;
+                        }
+
+                        for (size_t i = Slab; i != 0; --i)
+                             slab[i - 1].next = std::exchange(free, &slab[i - 1]);
+                    }
+
+                    return std::exchange(free, free->next);
+                }
+
+                void recycle(slot* s) noexcept
+                {
+                    std::lock_guard<std::mutex> lock(carving);
+                    s->next = std::exchange(free, s);
+                }
+
+                // frees the slabs with every slot on the free list, the list keeps the order of the slots that remain
+
+                void shed()
+                {
+                    std::lock_guard<std::mutex> lock(carving);
+
+                    std::ranges::sort(slabs);
+
+                    auto owner = [&](slot* s)
+                    {
+                        return std::ranges::upper_bound(slabs, s) - slabs.begin() - 1;
+                    };
+
+                    std::vector<size_t> counts(slabs.size());
+
+                    for (auto s = free; s; s = s->next)
+                         ++counts[owner(s)];
+
+                    if (std::ranges::find(counts, Slab) == counts.end())
+                        return;
+
+                    auto tail = &free;
+
+                    for (auto s = free; s; s = s->next)
+                    {
+                         if (counts[owner(s)] != Slab)
+                         {
+                             *tail = s;
+                             tail = &s->next;
+                         }
+                    }
+
+                    *tail = nullptr;
+
+                    size_t kept = 0;
+
+                    for (size_t i = 0; i != slabs.size(); ++i)
+                    {
+                         if (counts[i] != Slab)
+                             slabs[kept++] = slabs[i];
+                         else
+                             upstream->deallocate(slabs[i], sizeof(slot) * Slab, alignof(slot));
+                    }
+
+                    slabs.resize(kept);
+                }
+
+                // parks a magazine in the depot, destroying the objects that would take the depot past the limit
+
+                void park(magazine* m) noexcept
+                {
+                    auto old = stored.load(std::memory_order_relaxed);
+                    size_t fit;
+
+                    do
+                    {
+                        fit = old < limit ? std::min(m->count, limit - old) : 0;
+                    }
+                    while (!stored.compare_exchange_weak(old, old + fit, std::memory_order_relaxed));
+
+                    while (m->count != fit)
+                         destroy(m->objects[--m->count]);
+
+                    if (m->count)
+                        full.push(m);
+                    else
+                        empty.push(m);
+                }
+
+                magazine* unpark() noexcept
+                {
+                    auto m = full.pop();
+
+                    if (m)
+                        stored.fetch_sub(m->count, std::memory_order_relaxed);
+
+                    return m;
+                }
+
+                void clear(magazine* m) noexcept
+                {
+                    while (m->count)
+                         destroy(m->objects[--m->count]);
+                }
+
+                depot(size_t limit) : limit(limit)
+                {
+                }
+
+                ~depot()
+                {
+                    for (auto m = all.load(); m; )
+                    {
+                         for (size_t i = 0; i != m->count; ++i)
+                              destroy(m->objects[i]);
+
+                         auto dead = std::exchange(m, m->link);
+
+                         dead->~magazine();
+                         upstream->deallocate(dead, sizeof(magazine), alignof(magazine));
+                    }
+
+                    for (auto slab : slabs)
+                         upstream->deallocate(slab, sizeof(slot) * Slab, alignof(slot));
+                }
+
+                stack full;
+                stack empty;
+
+                std::atomic<magazine*> all = nullptr;
+
+                slot* free = nullptr;
+                std::mutex carving;
+
+                std::vector<slot*> slabs;
+
+                // objects, slabs and magazines are allocated from upstream, a pool_resource sets its own before first use
+
+                std::pmr::memory_resource* upstream = std::pmr::new_delete_resource();
+
+                const size_t limit;
+                alignas(64) std::atomic<size_t> stored = 0;
+
+                std::function<bool(T&)> reset;
+                const uint64_t id = ids.fetch_add(1, std::memory_order_relaxed) + 1;
+
+                std::mutex registering;
+                std::deque<cache> caches;
+
+                cache* strays = nullptr;
+
+                alignas(64) std::atomic<size_t> live = 0;
+                std::atomic<size_t> high_water = 0;
+
+                // remaining starts far above any handle count, so releases racing close never take it to zero early
+
+                static constexpr int64_t bias = int64_t(1) << 62;
+
+                std::atomic<bool> closed = false;
+                std::atomic<int64_t> remaining = bias;
+
+                std::shared_ptr<depot> keep;
+            };
+
+            // the caches of one thread, keyed by depot id, ids are never reused so an entry of a dead depot is never found again
+
+            struct registry
+            {
+                struct entry
+                {
+                    uint64_t id = 0;
+                    std::weak_ptr<depot> owner;
+
+                    cache* c = nullptr;
+                };
+
+                cache& find(depot* d)
+                {
+                    if (last && last->id == d->id)
+                        return *last->c;
+
+                    entry* vacant = nullptr;
+
+                    for (auto& e : entries)
+                    {
+                         if (e.id == d->id)
+                             return *(last = &e)->c;
+
+                         if (!vacant && e.owner.expired())
+                             vacant = &e;
+                    }
+
+                    if (!vacant)
+                        vacant = &entries.emplace_back();
+
+                    *vacant = { d->id, d->weak_from_this(), d->attach() };
+
+                    return *(last = vacant)->c;
+                }
+
+                ~registry()
+                {
+                    exited = true;
+
+                    for (auto& e : entries)
+                    {
+                         if (auto d = e.owner.lock())
+                             d->detach(e.c);
+                    }
+                }
+
+                entry* last = nullptr;
+                std::deque<entry> entries;
+            };
+
+            static inline std::atomic<uint64_t> ids = 0;
+            static inline thread_local registry local;
+
+            // trivially destructible, so it still reads true for handles released by the thread after local is gone
+
+            static inline thread_local bool exited = false;
+
+            std::shared_ptr<depot> core;
+    };
+
+    template <typename T, size_t Slab = 0>
+    using object_pool_t = typename object_pool<T, Slab>::type;
+
+    template <typename T, size_t Slab = 0>
+    using object_pool_unique_t = typename object_pool<T, Slab>::unique_type;
+
+    template <typename T, size_t Slab = 0>
+    using object_pool_intrusive_t = typename object_pool<T, Slab>::intrusive_type;
+
+    // a memory resource over object pools of raw blocks from 8 to 1024 bytes, each in slabs of about 16 KiB taken from upstream,
+    // a block is cached by the thread that frees it, larger or over-aligned requests go to the upstream resource
+
+    class pool_resource : public std::pmr::memory_resource
+    {
+        public:
+            static constexpr size_t classes = 8;
+            static constexpr size_t largest = size_t(8) << (classes - 1);
+
+            explicit pool_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) : upstream(upstream)
+            {
+                std::apply([=](auto&... pool){ ((pool.core->upstream = upstream), ...); }, pools);
+            }
+
+            pool_resource(const pool_resource&) = delete;
+            pool_resource& operator=(const pool_resource&) = delete;
+
+            std::pmr::memory_resource* upstream_resource() const noexcept
+            {
+                return upstream;
+            }
+
+            // the statistics of the size class serving requests of the given size
+
+            object_pool_statistics snapshot(size_t bytes) const
+            {
+                object_pool_statistics stats;
+
+                dispatch(index(bytes), [&](auto& pool){ stats = pool.snapshot(); });
+
+                return stats;
+            }
+
+        protected:
+            void* do_allocate(size_t bytes, size_t alignment) override
+            {
+                void* p = nullptr;
+
+                if (alignment > alignof(std::max_align_t) || !dispatch(index(bytes), [&](auto& pool){ p = &pool.core->acquire()->value; }))
+                    p = upstream->allocate(bytes, alignment);
+
+                return p;
+            }
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override
+            {
+                if (alignment > alignof(std::max_align_t) || !dispatch(index(bytes), [&]<typename P>(P& pool){ pool.core->reclaim(static_cast<typename P::node*>(p)); }))
+                    upstream->deallocate(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
 
         private:
-            std::queue<std::unique_ptr<T>> objects;
+            template <size_t Size>
+            struct alignas(std::min(Size, alignof(std::max_align_t))) block
+            {
+                block() noexcept
+                {
+                }
+
+                std::byte bytes[Size];
+            };
+
+            template <size_t Size>
+            using size_class = object_pool<block<Size>, std::max<size_t>(16384 / Size, 16)>;
+
+            template <size_t... I>
+            static auto make(std::index_sequence<I...>) -> std::tuple<size_class<size_t(8) << I>...>;
+
+            static size_t index(size_t bytes) noexcept
+            {
+                return bytes > largest ? classes : std::bit_width(std::max<size_t>(bytes, 8) - 1) - 3;
+            }
+
+            template <typename F>
+            bool dispatch(size_t i, F&& f) const
+            {
+                return std::apply([&](auto&... pool)
+                {
+                    size_t j = 0;
+
+                    return ((j++ == i && (f(pool), true)) || ...);
+                }, pools);
+            }
+
+            std::pmr::memory_resource* upstream;
+            mutable decltype(make(std::make_index_sequence<classes>())) pools;
     };
 
-    template <typename T>
-    using object_pool_t = typename object_pool<T>::type;
+    // a monotonic arena for the allocations that all die together, it releases its chunks only when destroyed or released
+
+    using arena_resource = std::pmr::monotonic_buffer_resource;
 }
 
 #endif
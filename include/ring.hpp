@@ -10,16 +10,88 @@
 #ifndef RING_HPP 
 #define RING_HPP
 
+#include <bit>
+#include <span>
 #include <array>
 #include <atomic>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <utility>
 #include <optional>
+#include <algorithm>
 
 namespace monster
 {    
+    // the buffer of ring and spsc_ring, a power of two capacity masks its indices, a capacity of
+    // std::dynamic_extent is chosen at run time, rounded up to a power of two and allocated on the heap
+
+    template <typename T, size_t N>
+    struct ring_storage
+    {
+        static_assert(N > 0, "capacity must not be zero");
+
+        static constexpr size_t capacity() noexcept
+        {
+            return N;
+        }
+
+        static constexpr size_t index(size_t pos) noexcept
+        {
+            if constexpr (std::has_single_bit(N))
+                return pos & (N - 1);
+            else
+                return pos % N;
+        }
+
+        T* data() noexcept
+        {
+            return buffer.data();
+        }
+
+        std::array<T, N> buffer{};
+    };
+
+    template <typename T>
+    struct ring_storage<T, std::dynamic_extent>
+    {
+        explicit ring_storage(size_t n) : mask(std::bit_ceil(std::max<size_t>(n, 1)) - 1), buffer(std::make_unique<T[]>(mask + 1))
+        {
+        }
+
+        size_t capacity() const noexcept
+        {
+            return mask + 1;
+        }
+
+        size_t index(size_t pos) const noexcept
+        {
+            return pos & mask;
+        }
+
+        T* data() noexcept
+        {
+            return buffer.get();
+        }
+
+        size_t mask;
+        std::unique_ptr<T[]> buffer;
+    };
+
+    // a bounded ring for exactly one producer thread and one consumer thread, the indices are
+    // plain members published through size_, so a second producer or consumer corrupts it,
+    // use spsc_ring for the same contract with less sharing, or mpmc_ring for any number of threads
+
     template <typename T, size_t N>
     class ring
     {
         public:
+            ring() = default;
+
+            explicit ring(size_t capacity) requires (N == std::dynamic_extent) : storage(capacity)
+            {
+            }
+
             bool push(T&& t)
             {
                 return do_push(std::move(t));
@@ -36,19 +108,82 @@ namespace monster
 
                 if (size() > 0)
                 {
-                    val = std::move(buffer[reader]);
+                    val = std::move(storage.data()[reader]);
 
-                    reader = (reader + 1) % N;
+                    reader = storage.index(reader + 1);
                     size_.fetch_sub(1);
                 }
     
                 return val;
             }
     
+            // pushes up to n elements read from first with a single publication, returns how many fit
+
+            template <typename I>
+            size_t push_bulk(I first, size_t n)
+            {
+                n = std::min(n, capacity() - size());
+
+                for (size_t i = 0; i != n; ++i, ++first)
+                     storage.data()[storage.index(writer + i)] = *first;
+
+                commit(n);
+
+                return n;
+            }
+
+            // pops up to n elements into out with a single publication, returns how many were taken
+
+            template <typename O>
+            size_t pop_bulk(O out, size_t n)
+            {
+                n = std::min(n, size());
+
+                for (size_t i = 0; i != n; ++i, ++out)
+                     *out = std::move(storage.data()[storage.index(reader + i)]);
+
+                release(n);
+
+                return n;
+            }
+
+            // the free slots from the writer up to n, contiguous so they stop at the end of the buffer,
+            // the producer fills them in place and publishes a prefix with commit
+
+            std::span<T> reserve(size_t n) noexcept
+            {
+                return { storage.data() + writer, std::min({ n, capacity() - size(), capacity() - writer }) };
+            }
+
+            void commit(size_t n) noexcept
+            {
+                writer = storage.index(writer + n);
+                size_.fetch_add(n);
+            }
+
+            // the readable elements from the reader up to n, contiguous, the consumer handles them
+            // in place and hands a prefix back with release
+
+            std::span<T> peek(size_t n) noexcept
+            {
+                return { storage.data() + reader, std::min({ n, size(), capacity() - reader }) };
+            }
+
+            void release(size_t n) noexcept
+            {
+                reader = storage.index(reader + n);
+                size_.fetch_sub(n);
+            }
+
             auto size() const noexcept
             {
                 return size_.load();
             }
+
+            size_t capacity() const noexcept
+            {
+                return storage.capacity();
+            }
     
             bool empty() const noexcept
             {
@@ -58,12 +193,12 @@ namespace monster
         private:
             bool do_push(auto&& t)
             {
-                if (size() == N)
+                if (size() == capacity())
                     return false;
     
-                buffer[writer] = std::forward<decltype(t)>(t);
+                storage.data()[writer] = std::forward<decltype(t)>(t);
 
-                writer = (writer + 1) % N;
+                writer = storage.index(writer + 1);
                 size_.fetch_add(1);
     
                 return true;
@@ -72,9 +207,456 @@ namespace monster
             size_t reader = 0;
             size_t writer = 0;
 
-            std::array<T, N> buffer{};
+            ring_storage<T, N> storage;
             std::atomic<size_t> size_{0};
     };
+
+    // a bounded single-producer single-consumer ring, the producer owns tail and the consumer owns head,
+    // each on its own cache line next to a cached copy of the other index, so an operation only reads
+    // the shared line of the other side when the cached copy says the ring is full or empty
+
+    template <typename T, size_t N>
+    class spsc_ring
+    {
+        public:
+            spsc_ring() = default;
+
+            explicit spsc_ring(size_t capacity) requires (N == std::dynamic_extent) : storage(capacity)
+            {
+            }
+
+            bool push(T&& t)
+            {
+                return do_push(std::move(t));
+            }
+
+            bool push(const T& t)
+            {
+                return do_push(t);
+            }
+
+            auto pop() -> std::optional<T>
+            {
+                auto val = std::optional<T>();
+                auto pos = head.load(std::memory_order_relaxed);
+
+                if (pos == cached_tail)
+                {
+                    cached_tail = tail.load(std::memory_order_acquire);
+
+                    if (pos == cached_tail)
+                        return val;
+                }
+
+                val = std::move(storage.data()[storage.index(pos)]);
+                head.store(pos + 1, std::memory_order_release);
+
+                return val;
+            }
+
+            template <typename I>
+            size_t push_bulk(I first, size_t n)
+            {
+                auto pos = tail.load(std::memory_order_relaxed);
+                n = std::min(n, writable(pos, n));
+
+                for (size_t i = 0; i != n; ++i, ++first)
+                     storage.data()[storage.index(pos + i)] = *first;
+
+                tail.store(pos + n, std::memory_order_release);
+
+                return n;
+            }
+
+            template <typename O>
+            size_t pop_bulk(O out, size_t n)
+            {
+                auto pos = head.load(std::memory_order_relaxed);
+                n = std::min(n, readable(pos, n));
+
+                for (size_t i = 0; i != n; ++i, ++out)
+                     *out = std::move(storage.data()[storage.index(pos + i)]);
+
+                head.store(pos + n, std::memory_order_release);
+
+                return n;
+            }
+
+            std::span<T> reserve(size_t n) noexcept
+            {
+                auto pos = tail.load(std::memory_order_relaxed);
+
+                return { storage.data() + storage.index(pos), std::min({ n, writable(pos, n), capacity() - storage.index(pos) }) };
+            }
+
+            void commit(size_t n) noexcept
+            {
+                tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+            }
+
+            std::span<T> peek(size_t n) noexcept
+            {
+                auto pos = head.load(std::memory_order_relaxed);
+
+                return { storage.data() + storage.index(pos), std::min({ n, readable(pos, n), capacity() - storage.index(pos) }) };
+            }
+
+            void release(size_t n) noexcept
+            {
+                head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+            }
+
+            auto size() const noexcept
+            {
+                auto h = head.load(std::memory_order_acquire);
+                auto t = tail.load(std::memory_order_acquire);
+
+                return t - h;
+            }
+
+            size_t capacity() const noexcept
+            {
+                return storage.capacity();
+            }
+
+            bool empty() const noexcept
+            {
+                return size() == 0;
+            }
+
+        private:
+            bool do_push(auto&& t)
+            {
+                auto pos = tail.load(std::memory_order_relaxed);
+
+                if (pos - cached_head == capacity())
+                {
+                    cached_head = head.load(std::memory_order_acquire);
+
+                    if (pos - cached_head == capacity())
+                        return false;
+                }
+
+                storage.data()[storage.index(pos)] = std::forward<decltype(t)>(t);
+                tail.store(pos + 1, std::memory_order_release);
+
+                return true;
+            }
+
+            // the free slots and the elements available, the cached index is refreshed only when it falls short of n
+
+            size_t writable(size_t pos, size_t n) noexcept
+            {
+                if (capacity() - (pos - cached_head) < n)
+                    cached_head = head.load(std::memory_order_acquire);
+
+                return capacity() - (pos - cached_head);
+            }
+
+            size_t readable(size_t pos, size_t n) noexcept
+            {
+                if (cached_tail - pos < n)
+                    cached_tail = tail.load(std::memory_order_acquire);
+
+                return cached_tail - pos;
+            }
+
+            alignas(64) std::atomic<size_t> head{0};
+            size_t cached_tail = 0;
+
+            alignas(64) std::atomic<size_t> tail{0};
+            size_t cached_head = 0;
+
+            alignas(64) ring_storage<T, N> storage;
+    };
+
+    // a bounded multi-producer multi-consumer ring, every slot carries a sequence number
+    // that tells producers and consumers whose turn it is, so neither side takes a lock,
+    // try_push and try_pop return at once, push and pop sleep on atomic::wait until they succeed
+
+    template <typename T, size_t N>
+    class mpmc_ring
+    {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+        public:
+            mpmc_ring() : buffer(std::make_unique<slot[]>(N))
+            {
+                for (size_t i = 0; i != N; ++i)
+                     buffer[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            bool try_push(T&& t)
+            {
+                return do_push(std::move(t));
+            }
+
+            bool try_push(const T& t)
+            {
+                return do_push(t);
+            }
+
+            auto try_pop() -> std::optional<T>
+            {
+                auto val = std::optional<T>();
+                auto pos = reader.load(std::memory_order_relaxed);
+
+                while (true)
+                {
+                    auto& cell = buffer[pos & (N - 1)];
+                    auto seq = cell.sequence.load(std::memory_order_acquire);
+                    auto dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+                    if (dif == 0)
+                    {
+                        if (reader.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                        {
+                            val = std::move(cell.data);
+                            cell.sequence.store(pos + N, std::memory_order_release);
+
+                            wake(producers, popped);
+
+                            return val;
+                        }
+                    }
+                    else if (dif < 0)
+                        return val;
+                    else
+                        pos = reader.load(std::memory_order_relaxed);
+                }
+            }
+
+            void push(T&& t)
+            {
+                while (!try_push(std::move(t)))
+                     sleep(producers, popped, [this]{ return size() == N; });
+            }
+
+            void push(const T& t)
+            {
+                while (!try_push(t))
+                     sleep(producers, popped, [this]{ return size() == N; });
+            }
+
+            T pop()
+            {
+                while (true)
+                {
+                    if (auto val = try_pop())
+                        return std::move(*val);
+
+                    sleep(consumers, pushed, [this]{ return size() == 0; });
+                }
+            }
+
+            // seq_cst loads, a sleeper relies on them to observe a claim ordered before its registration
+
+            auto size() const noexcept
+            {
+                auto w = writer.load();
+                auto r = reader.load();
+
+                return w > r ? w - r : 0;
+            }
+
+            bool empty() const noexcept
+            {
+                return size() == 0;
+            }
+
+        private:
+            bool do_push(auto&& t)
+            {
+                auto pos = writer.load(std::memory_order_relaxed);
+
+                while (true)
+                {
+                    auto& cell = buffer[pos & (N - 1)];
+                    auto seq = cell.sequence.load(std::memory_order_acquire);
+                    auto dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+                    if (dif == 0)
+                    {
+                        if (writer.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                        {
+                            cell.data = std::forward<decltype(t)>(t);
+                            cell.sequence.store(pos + 1, std::memory_order_release);
+
+                            wake(consumers, pushed);
+
+                            return true;
+                        }
+                    }
+                    else if (dif < 0)
+                        return false;
+                    else
+                        pos = writer.load(std::memory_order_relaxed);
+                }
+            }
+
+            // a sleeper registers before it checks the indices and a claim is a seq_cst cas read before the
+            // sleeper count, so either the sleeper sees the claim or the claimer sees the sleeper and bumps
+            // the epoch, a slot claimed but not yet published makes the sleeper yield until it is
+
+            template <typename F>
+            void sleep(std::atomic<uint32_t>& sleepers, std::atomic<uint32_t>& epoch, F&& blocked)
+            {
+                auto e = epoch.load(std::memory_order_acquire);
+                sleepers.fetch_add(1);
+
+                if (blocked())
+                    epoch.wait(e, std::memory_order_acquire);
+                else
+                    std::this_thread::yield();
+
+                sleepers.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            static void wake(std::atomic<uint32_t>& sleepers, std::atomic<uint32_t>& epoch)
+            {
+                if (sleepers.load() != 0)
+                {
+                    epoch.fetch_add(1, std::memory_order_release);
+                    epoch.notify_all();
+                }
+            }
+
+            struct slot
+            {
+                std::atomic<size_t> sequence;
+                T data{};
+            };
+
+            alignas(64) std::atomic<size_t> reader{0};
+            alignas(64) std::atomic<size_t> writer{0};
+
+            alignas(64) std::atomic<uint32_t> pushed{0};
+            std::atomic<uint32_t> consumers{0};
+
+            alignas(64) std::atomic<uint32_t> popped{0};
+            std::atomic<uint32_t> producers{0};
+
+            alignas(64) std::unique_ptr<slot[]> buffer;
+    };
+
+    // an unbounded single-producer single-consumer queue of linked segments of S elements, the producer
+    // links a new segment when the last one is full, so push never fails, the consumer frees a drained
+    // segment by parking it as the producer's spare, so a steady state allocates nothing
+
+    template <typename T, size_t S = 256>
+    class segmented_ring
+    {
+        static_assert(S > 0, "segment size must not be zero");
+
+        public:
+            segmented_ring() : front(new segment), back(front)
+            {
+            }
+
+            segmented_ring(const segmented_ring&) = delete;
+            segmented_ring& operator=(const segmented_ring&) = delete;
+
+            void push(T&& t)
+            {
+                do_push(std::move(t));
+            }
+
+            void push(const T& t)
+            {
+                do_push(t);
+            }
+
+            auto pop() -> std::optional<T>
+            {
+                auto val = std::optional<T>();
+
+                if (popped == cached_pushed)
+                {
+                    cached_pushed = pushed.load(std::memory_order_acquire);
+
+                    if (popped == cached_pushed)
+                        return val;
+                }
+
+                // the producer links the next segment before it publishes the first element in it
+
+                if (read == S)
+                {
+                    auto drained = std::exchange(front, front->next);
+
+                    drained->next = nullptr;
+                    delete spare.exchange(drained, std::memory_order_acq_rel);
+
+                    read = 0;
+                }
+
+                val = std::move(front->slots[read++]);
+                head.store(++popped, std::memory_order_release);
+
+                return val;
+            }
+
+            auto size() const noexcept
+            {
+                auto h = head.load(std::memory_order_acquire);
+
+                return pushed.load(std::memory_order_acquire) - h;
+            }
+
+            bool empty() const noexcept
+            {
+                return size() == 0;
+            }
+
+            ~segmented_ring()
+            {
+                while (front)
+                     delete std::exchange(front, front->next);
+
+                delete spare.load();
+            }
+
+        private:
+            struct segment
+            {
+                std::array<T, S> slots{};
+                segment* next = nullptr;
+            };
+
+            void do_push(auto&& t)
+            {
+                if (written == S)
+                {
+                    auto next = spare.exchange(nullptr, std::memory_order_acq_rel);
+
+                    if (!next)
+                        next = new segment;
+
+                    back->next = next;
+                    back = next;
+
+                    written = 0;
+                }
+
+                back->slots[written++] = std::forward<decltype(t)>(t);
+                pushed.store(++count, std::memory_order_release);
+            }
+
+            alignas(64) std::atomic<size_t> head{0};
+            segment* front;
+
+            size_t read = 0;
+            size_t popped = 0;
+            size_t cached_pushed = 0;
+
+            alignas(64) std::atomic<size_t> pushed{0};
+            segment* back;
+
+            size_t written = 0;
+            size_t count = 0;
+
+            alignas(64) std::atomic<segment*> spare{nullptr};
+    };
 }
     
 #endif
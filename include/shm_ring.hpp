@@ -0,0 +1,283 @@
+//
+// Copyright (c) 2016-present DeepGrace (complex dot invoke at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// Official repository: https://github.com/deepgrace/monster
+//
+
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+
+#include <bit>
+#include <new>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// A single-producer single-consumer ring whose header and buffer live in a shared memory mapping,
+// one process pushes and another pops without any system call once both have attached, each
+// process keeps a cached copy of the other side's index, so one object plays one role only.
+
+namespace monster
+{
+    template <typename T>
+    class shm_ring
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "elements are copied between processes as bytes");
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "the indices must be lock-free to be shared");
+
+        public:
+            // creates a named POSIX shared memory object, capacity is rounded up to a power of two
+
+            static shm_ring create(const std::string& name, size_t capacity)
+            {
+                int fd = check(shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600), "shm_open");
+
+                return shm_ring(fd, capacity, name);
+            }
+
+            // the creator must have returned from create before another process attaches
+
+            static shm_ring attach(const std::string& name)
+            {
+                int fd = check(shm_open(name.c_str(), O_RDWR, 0), "shm_open");
+
+                return shm_ring(fd, name);
+            }
+
+#if defined(__linux__)
+            // creates an anonymous memfd mapping, hand fd() to the other process through fork or a unix socket
+
+            static shm_ring create(size_t capacity)
+            {
+                int fd = check(memfd_create("monster.shm_ring", MFD_CLOEXEC), "memfd_create");
+
+                return shm_ring(fd, capacity, {});
+            }
+#endif
+
+            // attaches to a mapping through a descriptor, which the ring duplicates
+
+            static shm_ring attach(int fd)
+            {
+                return shm_ring(check(dup(fd), "dup"), {});
+            }
+
+            shm_ring(shm_ring&& other) noexcept : fd_(std::exchange(other.fd_, -1)), bytes(std::exchange(other.bytes, 0)),
+            header(std::exchange(other.header, nullptr)), buffer(std::exchange(other.buffer, nullptr)),
+            cached(other.cached), name(std::move(other.name))
+            {
+            }
+
+            shm_ring& operator=(shm_ring&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    close();
+
+                    fd_ = std::exchange(other.fd_, -1);
+                    bytes = std::exchange(other.bytes, 0);
+
+                    header = std::exchange(other.header, nullptr);
+                    buffer = std::exchange(other.buffer, nullptr);
+
+                    cached = other.cached;
+                    name = std::move(other.name);
+                }
+
+                return *this;
+            }
+
+            bool push(const T& t) noexcept
+            {
+                auto pos = header->tail.load(std::memory_order_relaxed);
+
+                if (pos - cached >= capacity())
+                {
+                    cached = header->head.load(std::memory_order_acquire);
+
+                    if (pos - cached >= capacity())
+                        return false;
+                }
+
+                std::memcpy(buffer + (pos & header->mask), &t, sizeof(T));
+                header->tail.store(pos + 1, std::memory_order_release);
+
+                return true;
+            }
+
+            auto pop() noexcept -> std::optional<T>
+            {
+                auto val = std::optional<T>();
+                auto pos = header->head.load(std::memory_order_relaxed);
+
+                if (pos == cached)
+                {
+                    cached = header->tail.load(std::memory_order_acquire);
+
+                    if (pos == cached)
+                        return val;
+                }
+
+                val.emplace();
+                std::memcpy(&*val, buffer + (pos & header->mask), sizeof(T));
+
+                header->head.store(pos + 1, std::memory_order_release);
+
+                return val;
+            }
+
+            size_t size() const noexcept
+            {
+                auto h = header->head.load(std::memory_order_acquire);
+                auto t = header->tail.load(std::memory_order_acquire);
+
+                return t - h;
+            }
+
+            bool empty() const noexcept
+            {
+                return size() == 0;
+            }
+
+            size_t capacity() const noexcept
+            {
+                return header->mask + 1;
+            }
+
+            int fd() const noexcept
+            {
+                return fd_;
+            }
+
+            // removes the name, processes already attached keep their mapping
+
+            void unlink() noexcept
+            {
+                if (!name.empty())
+                    shm_unlink(std::exchange(name, {}).c_str());
+            }
+
+            ~shm_ring()
+            {
+                close();
+            }
+
+        private:
+            static constexpr uint64_t magic = 0x676e69726d6873; // "shmring"
+
+            // a process only ever writes the index of its own side, each on its own cache line
+
+            struct header_type
+            {
+                uint64_t magic;
+                uint64_t size;
+                uint64_t mask;
+
+                alignas(64) std::atomic<uint64_t> head;
+                alignas(64) std::atomic<uint64_t> tail;
+            };
+
+            static constexpr size_t offset = (sizeof(header_type) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+            shm_ring(int fd, size_t capacity, std::string name) : fd_(fd), name(std::move(name))
+            {
+                capacity = std::bit_ceil(std::max<size_t>(capacity, 1));
+                bytes = offset + capacity * sizeof(T);
+
+                if (ftruncate(fd_, bytes) == -1)
+                    fail("ftruncate");
+
+                map();
+
+                header = new (header) header_type{ magic, sizeof(T), capacity - 1, {}, {} };
+            }
+
+            shm_ring(int fd, std::string name) : fd_(fd), name(std::move(name))
+            {
+                struct stat st;
+
+                if (fstat(fd_, &st) == -1)
+                    fail("fstat");
+
+                bytes = st.st_size;
+                map();
+
+                if (bytes < sizeof(header_type) || header->magic != magic || header->size != sizeof(T) || bytes != offset + capacity() * sizeof(T))
+                {
+                    close();
+
+                    throw std::system_error(std::make_error_code(std::errc::invalid_argument), "shm_ring layout mismatch");
+                }
+
+                // a ring may have been used before, head is a safe stale view of the other side for either role
+
+                cached = header->head.load(std::memory_order_acquire);
+            }
+
+            void map()
+            {
+                auto addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+
+                if (addr == MAP_FAILED)
+                    fail("mmap");
+
+                header = static_cast<header_type*>(addr);
+                buffer = reinterpret_cast<T*>(static_cast<char*>(addr) + offset);
+            }
+
+            [[noreturn]] void fail(const char* what)
+            {
+                auto error = errno;
+                close();
+
+                throw std::system_error(error, std::generic_category(), what);
+            }
+
+            void close() noexcept
+            {
+                if (header)
+                    munmap(header, bytes);
+
+                if (fd_ != -1)
+                    ::close(fd_);
+
+                header = nullptr;
+                fd_ = -1;
+            }
+
+            static int check(int r, const char* what)
+            {
+                if (r == -1)
+                    throw std::system_error(errno, std::generic_category(), what);
+
+                return r;
+            }
+
+            int fd_ = -1;
+            size_t bytes = 0;
+
+            header_type* header = nullptr;
+            T* buffer = nullptr;
+
+            // the last index of the other side this process has seen, never ahead of it
+
+            uint64_t cached = 0;
+            std::string name;
+    };
+}
+
+#endif
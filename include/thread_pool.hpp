@@ -10,92 +10,2972 @@
 #ifndef THREAD_POOL_HPP
 #define THREAD_POOL_HPP
 
+#include <bit>
+#include <array>
 #include <mutex>
-#include <queue>
+#include <condition_variable>
+#include <tuple>
+#include <atomic>
+#include <chrono>
 #include <future>
+#include <limits>
 #include <memory>
 #include <thread>
+#include <string>
 #include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <variant>
+#include <fstream>
+#include <iterator>
+#include <coroutine>
+#include <optional>
+#include <stop_token>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
 #include <functional>
 #include <type_traits>
-#include <condition_variable>
+#include <ring.hpp>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <pthread.h>
+#endif
 
 namespace monster
 {
-    class thread_pool
+    // a move-only void() callable, small callables are stored in place without allocation
+
+    class inplace_task
     {
         public:
-            thread_pool(size_t size);
+            static constexpr size_t capacity = 64 - sizeof(void*);
 
-            template <typename F, typename... Args>
-            constexpr decltype(auto) post(F&& f, Args&&... args);
+            inplace_task() = default;
+
+            template <typename F>
+            requires (!std::is_same_v<std::decay_t<F>, inplace_task>)
+            inplace_task(F&& f)
+            {
+                using type = std::decay_t<F>;
+
+                if constexpr (inplace<type>)
+                    new (data) type(std::forward<F>(f));
+                else
+                    *reinterpret_cast<type**>(data) = new type(std::forward<F>(f));
 
-            ~thread_pool();
+                table = &operations<type>;
+            }
+
+            inplace_task(inplace_task&& other) noexcept
+            {
+                move(other);
+            }
+
+            inplace_task& operator=(inplace_task&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    move(other);
+                }
+
+                return *this;
+            }
+
+            void operator()()
+            {
+                table->invoke(data);
+            }
+
+            explicit operator bool() const noexcept
+            {
+                return table != nullptr;
+            }
+
+            void reset() noexcept
+            {
+                if (table)
+                {
+                    table->destroy(data);
+                    table = nullptr;
+                }
+            }
+
+            ~inplace_task()
+            {
+                reset();
+            }
 
         private:
-            bool stop = false;
+            struct vtable
+            {
+                void (*invoke)(void*);
+                void (*move)(void*, void*) noexcept;
+                void (*destroy)(void*) noexcept;
+            };
 
-            std::mutex mutex;
-            std::condition_variable cond;
+            template <typename T>
+            static constexpr bool inplace = sizeof(T) <= capacity && alignof(T) <= alignof(std::max_align_t) &&
+                                            std::is_nothrow_move_constructible_v<T>;
 
-            std::vector<std::thread> workers;
-            std::queue<std::function<void()>> tasks;
+            template <typename T>
+            static T* get(void* p) noexcept
+            {
+                if constexpr (inplace<T>)
+                    return reinterpret_cast<T*>(p);
+                else
+                    return *reinterpret_cast<T**>(p);
+            }
+
+            template <typename T>
+            static constexpr vtable operations
+            {
+                [](void* p)
+                {
+                    (*get<T>(p))();
+                },
+                [](void* dst, void* src) noexcept
+                {
+                    if constexpr (inplace<T>)
+                    {
+                        new (dst) T(std::move(*get<T>(src)));
+                        get<T>(src)->~T();
+                    }
+                    else
+                        *reinterpret_cast<T**>(dst) = get<T>(src);
+                },
+                [](void* p) noexcept
+                {
+                    if constexpr (inplace<T>)
+                        get<T>(p)->~T();
+                    else
+                        delete get<T>(p);
+                }
+            };
+
+            void move(inplace_task& other) noexcept
+            {
+                if (other.table)
+                {
+                    other.table->move(data, other.data);
+                    table = std::exchange(other.table, nullptr);
+                }
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+                stamp = other.stamp;
+#endif
+            }
+
+            alignas(std::max_align_t) char data[capacity];
+            const vtable* table = nullptr;
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+        public:
+            // when the task was posted, to measure how long it waited in the queue
+            std::chrono::steady_clock::time_point stamp;
+#endif
     };
 
-    thread_pool::thread_pool(size_t size)
+    using task_type = inplace_task;
+
+    // a growable ring buffer, it only allocates when it runs out of room
+
+    template <typename T>
+    class circular_deque
     {
-        for (size_t i = 0; i != size; ++i)
-             workers.emplace_back([this]
-             {
-                 while (true)
-                 {
-                     std::function<void()> task;
+        public:
+            bool empty() const noexcept
+            {
+                return count == 0;
+            }
 
-                     {
-                         std::unique_lock<std::mutex> lock(mutex);
-                         cond.wait(lock, [this]{ return stop || !tasks.empty(); });
+            size_t size() const noexcept
+            {
+                return count;
+            }
 
-                         if (stop && tasks.empty())
-                             return;
+            void push_back(T&& t)
+            {
+                if (count == capacity)
+                    grow();
 
-                         task = std::move(tasks.front());
-                         tasks.pop();
-                     }
+                buffer[(head + count++) & (capacity - 1)] = std::move(t);
+            }
+
+            T& front() noexcept
+            {
+                return buffer[head];
+            }
+
+            T pop_front()
+            {
+                T t = std::move(buffer[head]);
+
+                head = (head + 1) & (capacity - 1);
+                --count;
+
+                return t;
+            }
+
+            T pop_back()
+            {
+                return std::move(buffer[(head + --count) & (capacity - 1)]);
+            }
+
+        private:
+            void grow()
+            {
+                auto size = capacity ? capacity * 2 : 16;
+                auto data = std::make_unique<T[]>(size);
+
+                for (size_t i = 0; i != count; ++i)
+                     data[i] = std::move(buffer[(head + i) & (capacity - 1)]);
+
+                buffer = std::move(data);
+
+                head = 0;
+                capacity = size;
+            }
+
+            size_t head = 0;
+            size_t count = 0;
+            size_t capacity = 0;
+
+            std::unique_ptr<T[]> buffer;
+    };
+
+    // recycles nodes through a thread local cache, surplus nodes travel in batches through a shared depot,
+    // so nodes released on one thread and acquired on another are reused without touching the heap
+
+    template <typename T>
+    class recycler
+    {
+        public:
+            static T* acquire()
+            {
+                auto& local = cache;
+
+                if (!local.head)
+                    local.refill();
+
+                if (auto node = local.head)
+                {
+                    local.head = node->next;
+                    --local.count;
+
+                    return node;
+                }
+
+                return new T;
+            }
+
+            static void release(T* node) noexcept
+            {
+                auto& local = cache;
+
+                node->next = local.head;
+                local.head = node;
+
+                if (++local.count == 2 * batch)
+                    local.flush(batch);
+            }
+
+        private:
+            static constexpr size_t batch = 64;
+
+            struct depot
+            {
+                std::mutex mutex;
+                T* chains = nullptr;
+
+                ~depot()
+                {
+                    while (auto chain = chains)
+                    {
+                        chains = chain->chain;
+
+                        while (auto node = chain)
+                        {
+                            chain = node->next;
+                            delete node;
+                        }
+                    }
+                }
+            };
+
+            struct local_cache
+            {
+                T* head = nullptr;
+                size_t count = 0;
+
+                void refill()
+                {
+                    {
+                        std::unique_lock<std::mutex> lock(shared.mutex);
+
+                        if (!shared.chains)
+                            return;
+
+                        head = shared.chains;
+                        shared.chains = head->chain;
+                    }
+
+                    for (auto node = head; node; node = node->next)
+                         ++count;
+                }
+
+                void flush(size_t n) noexcept
+                {
+                    if (n == 0)
+                        return;
+
+                    auto chain = head;
+                    auto last = head;
+
+                    for (size_t i = 1; i != n; ++i)
+                         last = last->next;
+
+                    head = last->next;
+                    last->next = nullptr;
+                    count -= n;
+
+                    std::unique_lock<std::mutex> lock(shared.mutex);
+
+                    chain->chain = shared.chains;
+                    shared.chains = chain;
+                }
+
+                ~local_cache()
+                {
+                    flush(count);
+                }
+            };
+
+            static inline depot shared;
+            static inline thread_local local_cache cache;
+    };
+
+    // the shared state of a task_promise and task_future pair, recycled instead of freed
+
+    template <typename T>
+    class task_state
+    {
+        public:
+            using value_type = std::conditional_t<std::is_void_v<T>, std::monostate,
+                               std::conditional_t<std::is_reference_v<T>, std::reference_wrapper<std::remove_reference_t<T>>, T>>;
+
+            static task_state* make()
+            {
+                auto state = recycler<task_state>::acquire();
+                state->refs.store(1, std::memory_order_relaxed);
+
+                return state;
+            }
+
+            void retain() noexcept
+            {
+                refs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void release() noexcept
+            {
+                if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    value.reset();
+                    error = nullptr;
+                    continuation.reset();
+
+                    status.store(0, std::memory_order_relaxed);
+                    recycler<task_state>::release(this);
+                }
+            }
+
+            bool ready() const noexcept
+            {
+                return status.load(std::memory_order_acquire) & done;
+            }
+
+            void wait() const noexcept
+            {
+                for (auto s = status.load(std::memory_order_acquire); !(s & done); s = status.load(std::memory_order_acquire))
+                     status.wait(s, std::memory_order_acquire);
+            }
+
+            // f runs exactly once, on the thread that completes the state, or right here when it is already complete
+
+            template <typename F>
+            void attach(F&& f)
+            {
+                continuation = std::forward<F>(f);
+
+                if (status.fetch_or(attached, std::memory_order_acq_rel) & done)
+                    continuation();
+            }
+
+            template <typename... Args>
+            void set_value(Args&&... args)
+            {
+                value.emplace(std::forward<Args>(args)...);
+                complete();
+            }
+
+            void set_exception(std::exception_ptr e) noexcept
+            {
+                error = std::move(e);
+                complete();
+            }
+
+            T get()
+            {
+                if (error)
+                    std::rethrow_exception(error);
+
+                if constexpr (std::is_reference_v<T>)
+                    return value->get();
+                else if constexpr (!std::is_void_v<T>)
+                    return std::move(*value);
+            }
+
+            task_state* next = nullptr;
+            task_state* chain = nullptr;
+
+        private:
+            static constexpr unsigned done = 1;
+            static constexpr unsigned attached = 2;
+
+            void complete() noexcept
+            {
+                auto s = status.fetch_or(done, std::memory_order_acq_rel);
+                status.notify_all();
+
+                if (s & attached)
+                    continuation();
+            }
+
+            std::atomic<unsigned> refs = 0;
+            std::atomic<unsigned> status = 0;
+
+            std::exception_ptr error;
+            std::optional<value_type> value;
+
+            inplace_task continuation;
+    };
+
+    // a lightweight std::future, its shared state comes from a recycler rather than the heap
+
+    template <typename T>
+    class task_future
+    {
+        public:
+            task_future() = default;
+
+            explicit task_future(task_state<T>* state) : state(state)
+            {
+            }
+
+            task_future(task_future&& other) noexcept : state(std::exchange(other.state, nullptr))
+            {
+            }
+
+            task_future& operator=(task_future&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    if (state)
+                        state->release();
+
+                    state = std::exchange(other.state, nullptr);
+                }
+
+                return *this;
+            }
+
+            bool valid() const noexcept
+            {
+                return state != nullptr;
+            }
+
+            bool ready() const noexcept
+            {
+                return state->ready();
+            }
+
+            void wait() const noexcept
+            {
+                state->wait();
+            }
+
+            T get()
+            {
+                struct guard
+                {
+                    task_state<T>* state;
+
+                    ~guard()
+                    {
+                        state->release();
+                    }
+                } g{std::exchange(state, nullptr)};
+
+                g.state->wait();
+
+                return g.state->get();
+            }
+
+            // f runs once the result is available, the future stays valid
+
+            template <typename F>
+            void on_ready(F&& f)
+            {
+                state->attach(std::forward<F>(f));
+            }
+
+            // consumes the future, f receives the value on the completing thread or on the executor,
+            // an exception skips f and is forwarded to the returned future
+
+            template <typename F>
+            auto then(F&& f)
+            {
+                return chain([](task_type&& task){ task(); }, std::forward<F>(f));
+            }
+
+            template <typename Executor, typename F>
+            auto then(Executor& executor, F&& f)
+            {
+                return chain([&executor](task_type&& task){ executor.execute(std::move(task)); }, std::forward<F>(f));
+            }
+
+            // a coroutine awaiting the future is resumed on the thread that completes it
+
+            auto operator co_await() noexcept
+            {
+                struct awaiter
+                {
+                    task_future& future;
+
+                    bool await_ready() const noexcept
+                    {
+                        return future.ready();
+                    }
+
+                    void await_suspend(std::coroutine_handle<> handle)
+                    {
+                        future.on_ready([handle]{ handle.resume(); });
+                    }
+
+                    T await_resume()
+                    {
+                        return future.get();
+                    }
+                };
+
+                return awaiter{*this};
+            }
+
+            ~task_future()
+            {
+                if (state)
+                    state->release();
+            }
 
-                     task();
-                 }
-             });
+        private:
+            template <typename F>
+            using result_t = typename std::conditional_t<std::is_void_v<T>, std::invoke_result<F&>, std::invoke_result<F&, T>>::type;
+
+            template <typename D, typename F>
+            auto chain(D dispatch, F&& f);
+
+            task_state<T>* state = nullptr;
+    };
+
+    template <typename T>
+    class task_promise
+    {
+        public:
+            task_promise() : state(task_state<T>::make())
+            {
+            }
+
+            task_promise(task_promise&& other) noexcept : state(std::exchange(other.state, nullptr))
+            {
+            }
+
+            task_promise& operator=(task_promise&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    abandon();
+                    state = std::exchange(other.state, nullptr);
+                }
+
+                return *this;
+            }
+
+            task_future<T> get_future()
+            {
+                state->retain();
+
+                return task_future<T>(state);
+            }
+
+            template <typename... Args>
+            void set_value(Args&&... args)
+            {
+                state->set_value(std::forward<Args>(args)...);
+            }
+
+            void set_exception(std::exception_ptr e) noexcept
+            {
+                state->set_exception(std::move(e));
+            }
+
+            template <typename F>
+            void set_from(F&& f) noexcept
+            {
+                try
+                {
+                    if constexpr (std::is_void_v<T>)
+                    {
+                        std::forward<F>(f)();
+                        set_value();
+                    }
+                    else
+                        set_value(std::forward<F>(f)());
+                }
+                catch (...)
+                {
+                    set_exception(std::current_exception());
+                }
+            }
+
+            ~task_promise()
+            {
+                abandon();
+            }
+
+        private:
+            void abandon() noexcept
+            {
+                if (!state)
+                    return;
+
+                if (!state->ready())
+                    state->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+
+                std::exchange(state, nullptr)->release();
+            }
+
+            task_state<T>* state;
+    };
+
+    template <typename T>
+    template <typename D, typename F>
+    auto task_future<T>::chain(D dispatch, F&& f)
+    {
+        using type = result_t<std::decay_t<F>>;
+
+        task_promise<type> promise;
+        auto fut = promise.get_future();
+
+        auto s = std::exchange(state, nullptr);
+
+        s->attach([s, dispatch, promise = std::move(promise), f = std::forward<F>(f)] mutable
+        {
+            // the input is held by a future so a dispatch that is dropped still releases it
+
+            dispatch([input = task_future<T>(s), promise = std::move(promise), f = std::move(f)] mutable
+            {
+                promise.set_from([&]() -> type
+                {
+                    if constexpr (std::is_void_v<T>)
+                    {
+                        input.state->get();
+
+                        return std::invoke(f);
+                    }
+                    else
+                        return std::invoke(f, input.state->get());
+                });
+            });
+        });
+
+        return fut;
     }
 
-    template <typename F, typename... Args>
-    constexpr decltype(auto) thread_pool::post(F&& f, Args&&... args)
+    // completes once every future is ready, the ready futures are handed back for inspection
+
+    template <typename Seq>
+    struct when_all_state
     {
-        using type = std::packaged_task<std::invoke_result_t<F, Args...>()>;
-        auto task = std::make_shared<type>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        Seq futures;
+        std::atomic<size_t> remaining;
 
-        auto fut = task->get_future();
+        task_promise<Seq> promise;
 
+        void operator()()
         {
-            std::unique_lock<std::mutex> lock(mutex);
-            tasks.emplace([task]{ (*task)(); });
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                promise.set_value(std::move(futures));
+                delete this;
+            }
         }
+    };
+
+    template <typename T>
+    task_future<std::vector<task_future<T>>> when_all(std::vector<task_future<T>> futures)
+    {
+        using type = std::vector<task_future<T>>;
+
+        auto n = futures.size();
+        auto state = new when_all_state<type>{ std::move(futures), n + 1 };
+
+        auto fut = state->promise.get_future();
+
+        for (auto& f : state->futures)
+             f.on_ready([state]{ (*state)(); });
 
-        cond.notify_one();
+        (*state)();
 
         return fut;
     }
 
-    thread_pool::~thread_pool()
+    template <typename... T>
+    task_future<std::tuple<task_future<T>...>> when_all(task_future<T>&&... futures)
+    {
+        using type = std::tuple<task_future<T>...>;
+
+        auto state = new when_all_state<type>{ type(std::move(futures)...), sizeof...(T) + 1 };
+        auto fut = state->promise.get_future();
+
+        std::apply([state](auto&... f){ (f.on_ready([state]{ (*state)(); }), ...); }, state->futures);
+        (*state)();
+
+        return fut;
+    }
+
+    template <typename Seq>
+    struct when_any_result
+    {
+        size_t index;
+        Seq futures;
+    };
+
+    // completes with the index of the first ready future, the state lives until every future has fired
+
+    template <typename Seq>
+    struct when_any_state
     {
+        Seq futures;
+        std::atomic<size_t> remaining;
+
+        std::atomic<size_t> first = std::numeric_limits<size_t>::max();
+        std::atomic<unsigned> gate = 2;
+
+        task_promise<when_any_result<Seq>> promise;
+
+        void open()
         {
-            std::unique_lock<std::mutex> lock(mutex);
-            stop = true;
+            if (gate.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                promise.set_value(when_any_result<Seq>{ first.load(std::memory_order_acquire), std::move(futures) });
         }
 
-        cond.notify_all();
+        void operator()(size_t i)
+        {
+            auto none = std::numeric_limits<size_t>::max();
 
-        for (auto& worker: workers)
-             worker.join();
+            if (first.compare_exchange_strong(none, i, std::memory_order_acq_rel))
+                open();
+
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete this;
+        }
+    };
+
+    template <typename T>
+    task_future<when_any_result<std::vector<task_future<T>>>> when_any(std::vector<task_future<T>> futures)
+    {
+        using type = std::vector<task_future<T>>;
+
+        auto n = futures.size();
+        auto state = new when_any_state<type>{ std::move(futures), n + 1 };
+
+        auto fut = state->promise.get_future();
+
+        if (n == 0)
+            state->gate.fetch_sub(1);
+
+        for (size_t i = 0; i != n; ++i)
+             state->futures[i].on_ready([state, i]{ (*state)(i); });
+
+        // the futures are moved into the result only after every callback is attached
+
+        state->open();
+
+        if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete state;
+
+        return fut;
+    }
+
+    template <typename T>
+    class task;
+
+    template <typename T>
+    struct task_value
+    {
+        std::optional<typename task_state<T>::value_type> value;
+
+        template <typename U>
+        void return_value(U&& u)
+        {
+            value.emplace(std::forward<U>(u));
+        }
+
+        T result()
+        {
+            if constexpr (std::is_reference_v<T>)
+                return value->get();
+            else
+                return std::move(*value);
+        }
+    };
+
+    template <>
+    struct task_value<void>
+    {
+        void return_void() noexcept
+        {
+        }
+
+        void result() noexcept
+        {
+        }
+    };
+
+    // a lazy coroutine, it starts when awaited and resumes its awaiter by symmetric transfer
+    // once it finishes, so a chain of awaiting tasks never blocks a thread
+
+    template <typename T = void>
+    class task
+    {
+        public:
+            struct promise_type : task_value<T>
+            {
+                std::exception_ptr error;
+                std::coroutine_handle<> continuation = std::noop_coroutine();
+
+                task get_return_object() noexcept
+                {
+                    return task(std::coroutine_handle<promise_type>::from_promise(*this));
+                }
+
+                std::suspend_always initial_suspend() noexcept
+                {
+                    return {};
+                }
+
+                auto final_suspend() noexcept
+                {
+                    struct awaiter
+                    {
+                        bool await_ready() const noexcept
+                        {
+                            return false;
+                        }
+
+                        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                        {
+                            return handle.promise().continuation;
+                        }
+
+                        void await_resume() const noexcept
+                        {
+                        }
+                    };
+
+                    return awaiter{};
+                }
+
+                void unhandled_exception() noexcept
+                {
+                    error = std::current_exception();
+                }
+            };
+
+            task(task&& other) noexcept : handle(std::exchange(other.handle, nullptr))
+            {
+            }
+
+            task& operator=(task&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    if (handle)
+                        handle.destroy();
+
+                    handle = std::exchange(other.handle, nullptr);
+                }
+
+                return *this;
+            }
+
+            auto operator co_await() noexcept
+            {
+                struct awaiter
+                {
+                    std::coroutine_handle<promise_type> handle;
+
+                    bool await_ready() const noexcept
+                    {
+                        return handle.done();
+                    }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                    {
+                        handle.promise().continuation = awaiting;
+
+                        return handle;
+                    }
+
+                    T await_resume()
+                    {
+                        if (handle.promise().error)
+                            std::rethrow_exception(handle.promise().error);
+
+                        return handle.promise().result();
+                    }
+                };
+
+                return awaiter{handle};
+            }
+
+            ~task()
+            {
+                if (handle)
+                    handle.destroy();
+            }
+
+        private:
+            explicit task(std::coroutine_handle<promise_type> handle) : handle(handle)
+            {
+            }
+
+            std::coroutine_handle<promise_type> handle;
+    };
+
+    // a coroutine that owns its frame and frees it when it runs off the end
+
+    struct detached_task
+    {
+        struct promise_type
+        {
+            detached_task get_return_object() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_never final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void() noexcept
+            {
+            }
+
+            void unhandled_exception() noexcept
+            {
+                std::terminate();
+            }
+        };
+    };
+
+    template <typename Executor, typename T>
+    detached_task launch(Executor& executor, task<T> t, task_promise<T> promise)
+    {
+        try
+        {
+            co_await executor.schedule();
+
+            if constexpr (std::is_void_v<T>)
+            {
+                co_await t;
+                promise.set_value();
+            }
+            else
+                promise.set_value(co_await t);
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    // starts a task on the executor, the future completes with its result
+
+    template <typename Executor, typename T>
+    task_future<T> spawn(Executor& executor, task<T> t)
+    {
+        task_promise<T> promise;
+        auto fut = promise.get_future();
+
+        launch(executor, std::move(t), std::move(promise));
+
+        return fut;
+    }
+
+    // a dependency graph of tasks, a node is handed to the executor as soon as its last
+    // predecessor finishes, so no worker ever blocks waiting for its inputs
+
+    class task_graph
+    {
+        public:
+            template <typename F>
+            size_t emplace(F&& f)
+            {
+                nodes.push_back({ std::forward<F>(f) });
+
+                return nodes.size() - 1;
+            }
+
+            void precede(size_t from, size_t to)
+            {
+                nodes[from].successors.push_back(to);
+                ++nodes[to].dependencies;
+            }
+
+            size_t size() const noexcept
+            {
+                return nodes.size();
+            }
+
+            // the graph must outlive the run, the first exception skips the remaining nodes and is forwarded
+
+            template <typename Executor>
+            task_future<void> run(Executor& executor);
+
+        private:
+            struct node
+            {
+                task_type work;
+
+                size_t dependencies = 0;
+                std::vector<size_t> successors;
+            };
+
+            template <typename Executor>
+            struct execution
+            {
+                task_graph* graph;
+                Executor* executor;
+
+                std::vector<std::atomic<size_t>> counters;
+                std::atomic<size_t> remaining;
+
+                std::atomic<bool> failed = false;
+                std::exception_ptr error;
+
+                task_promise<void> promise;
+
+                // a node dropped by an aborting executor fails the run, its successors are released without running
+
+                struct step
+                {
+                    execution* self;
+                    size_t index;
+
+                    step(execution* self, size_t index) noexcept : self(self), index(index)
+                    {
+                    }
+
+                    step(step&& other) noexcept : self(std::exchange(other.self, nullptr)), index(other.index)
+                    {
+                    }
+
+                    void operator()()
+                    {
+                        std::exchange(self, nullptr)->run(index);
+                    }
+
+                    ~step()
+                    {
+                        if (self)
+                            self->drop(index);
+                    }
+                };
+
+                void schedule(size_t i)
+                {
+                    executor->execute(step(this, i));
+                }
+
+                void drop(size_t i)
+                {
+                    if (!failed.exchange(true))
+                        error = std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+
+                    run(i);
+                }
+
+                void run(size_t i)
+                {
+                    while (true)
+                    {
+                        auto& node = graph->nodes[i];
+
+                        if (!failed.load(std::memory_order_relaxed))
+                        {
+                            try
+                            {
+                                node.work();
+                            }
+                            catch (...)
+                            {
+                                if (!failed.exchange(true))
+                                    error = std::current_exception();
+                            }
+                        }
+
+                        // the last successor that becomes ready runs on this thread
+
+                        auto next = npos;
+
+                        for (auto s : node.successors)
+                        {
+                             if (counters[s].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                             {
+                                 if (next != npos)
+                                     schedule(next);
+
+                                 next = s;
+                             }
+                        }
+
+                        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        {
+                            if (error)
+                                promise.set_exception(error);
+                            else
+                                promise.set_value();
+
+                            delete this;
+
+                            return;
+                        }
+
+                        if (next == npos)
+                            return;
+
+                        i = next;
+                    }
+                }
+
+                static constexpr size_t npos = std::numeric_limits<size_t>::max();
+            };
+
+            bool acyclic() const;
+
+            std::vector<node> nodes;
+    };
+
+    inline bool task_graph::acyclic() const
+    {
+        std::vector<size_t> degrees;
+        std::vector<size_t> ready;
+
+        for (size_t i = 0; i != nodes.size(); ++i)
+        {
+             degrees.push_back(nodes[i].dependencies);
+
+             if (degrees.back() == 0)
+                 ready.push_back(i);
+        }
+
+        size_t visited = 0;
+
+        while (!ready.empty())
+        {
+            auto i = ready.back();
+
+            ready.pop_back();
+            ++visited;
+
+            for (auto s : nodes[i].successors)
+            {
+                 if (--degrees[s] == 0)
+                     ready.push_back(s);
+            }
+        }
+
+        return visited == nodes.size();
+    }
+
+    template <typename Executor>
+    task_future<void> task_graph::run(Executor& executor)
+    {
+        if (!acyclic())
+            throw std::logic_error("task_graph contains a cycle");
+
+        auto n = nodes.size();
+        auto state = new execution<Executor>{ this, &executor, std::vector<std::atomic<size_t>>(n), n };
+
+        auto fut = state->promise.get_future();
+
+        if (n == 0)
+        {
+            state->promise.set_value();
+            delete state;
+
+            return fut;
+        }
+
+        std::vector<size_t> roots;
+
+        for (size_t i = 0; i != n; ++i)
+        {
+             state->counters[i].store(nodes[i].dependencies, std::memory_order_relaxed);
+
+             if (nodes[i].dependencies == 0)
+                 roots.push_back(i);
+        }
+
+        for (auto i : roots)
+             state->schedule(i);
+
+        return fut;
+    }
+
+    // index of the calling worker, or npos when the caller is not a worker of the pool
+
+    inline constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    // a single queue shared by all the workers, guarded by one lock
+
+    class fifo_queue
+    {
+        public:
+            explicit fifo_queue(size_t)
+            {
+            }
+
+            void push(task_type&& task, size_t)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+
+            template <typename G>
+            void push_bulk(size_t n, G&& make, size_t)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                for (size_t i = 0; i != n; ++i)
+                     tasks.push_back(make(i));
+            }
+
+            bool pop(task_type& task, size_t)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                if (tasks.empty())
+                    return false;
+
+                task = tasks.pop_front();
+
+                return true;
+            }
+
+        private:
+            std::mutex mutex;
+            circular_deque<task_type> tasks;
+    };
+
+    // each worker owns a deque, tasks posted from a worker stay on its deque,
+    // the owner pops from the back while idle workers steal from the front of the others
+
+    class work_stealing
+    {
+        public:
+            explicit work_stealing(size_t size) : lanes(size ? size : 1)
+            {
+            }
+
+            void push(task_type&& task, size_t index)
+            {
+                if (index == npos)
+                    index = next.fetch_add(1, std::memory_order_relaxed) % lanes.size();
+
+                auto& lane = lanes[index];
+
+                std::unique_lock<std::mutex> lock(lane.mutex);
+                lane.tasks.push_back(std::move(task));
+            }
+
+            // a worker keeps the whole batch for the others to steal, an external batch is split across the lanes
+
+            template <typename G>
+            void push_bulk(size_t n, G&& make, size_t index)
+            {
+                auto size = lanes.size();
+                auto step = index == npos ? (n + size - 1) / size : n;
+
+                if (index == npos)
+                    index = next.fetch_add(1, std::memory_order_relaxed) % size;
+
+                for (size_t i = 0; i < n; i += step, index = (index + 1) % size)
+                {
+                     auto& lane = lanes[index];
+                     std::unique_lock<std::mutex> lock(lane.mutex);
+
+                     for (size_t j = i; j != std::min(i + step, n); ++j)
+                          lane.tasks.push_back(make(j));
+                }
+            }
+
+            bool pop(task_type& task, size_t index)
+            {
+                auto size = lanes.size();
+
+                if (index != npos)
+                {
+                    auto& lane = lanes[index];
+                    std::unique_lock<std::mutex> lock(lane.mutex);
+
+                    if (!lane.tasks.empty())
+                    {
+                        task = lane.tasks.pop_back();
+
+                        return true;
+                    }
+                }
+
+                for (size_t i = 1; i <= size; ++i)
+                {
+                     auto& lane = lanes[(index + i) % size];
+                     std::unique_lock<std::mutex> lock(lane.mutex, std::try_to_lock);
+
+                     if (lock && !lane.tasks.empty())
+                     {
+                         task = lane.tasks.pop_front();
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+                         stolen.fetch_add(index != npos, std::memory_order_relaxed);
+#endif
+                         return true;
+                     }
+                }
+
+                return false;
+            }
+
+            size_t steals() const noexcept
+            {
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+                return stolen.load(std::memory_order_relaxed);
+#else
+                return 0;
+#endif
+            }
+
+        private:
+            struct alignas(64) lane
+            {
+                std::mutex mutex;
+                circular_deque<task_type> tasks;
+            };
+
+            std::vector<lane> lanes;
+            std::atomic<size_t> next = 0;
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+            std::atomic<size_t> stolen = 0;
+#endif
+    };
+
+    // an index space is either a pair of integers or a pair of iterators
+
+    template <typename I>
+    constexpr size_t index_distance(I first, I last)
+    {
+        if constexpr (std::is_integral_v<I>)
+            return first < last ? last - first : 0;
+        else
+            return std::distance(first, last);
+    }
+
+    // integers and random access iterators reach any index in constant time, other iterators
+    // are walked once up front to the start of every stride, so a batch stays linear in its size
+
+    template <typename I>
+    concept indexable = std::is_integral_v<I> || std::random_access_iterator<I>;
+
+    template <indexable I>
+    constexpr decltype(auto) index_at(I first, size_t i)
+    {
+        if constexpr (std::is_integral_v<I>)
+            return static_cast<I>(first + i);
+        else
+            return first[i];
+    }
+
+    template <typename I>
+    std::vector<I> index_strides(I first, size_t n, size_t stride)
+    {
+        std::vector<I> starts;
+        starts.reserve((n + stride - 1) / stride);
+
+        for (size_t i = 0; i < n; i += stride)
+        {
+             starts.push_back(first);
+             std::advance(first, std::min(stride, n - i));
+        }
+
+        return starts;
+    }
+
+    // shared by every task of a batch, the last task to finish completes the promise and frees it
+
+    template <typename F>
+    struct bulk_state
+    {
+        F f;
+
+        std::atomic<size_t> remaining;
+        std::atomic<bool> failed = false;
+
+        std::exception_ptr error;
+        task_promise<void> promise;
+
+        void operator()(size_t i)
+        {
+            try
+            {
+                f(i);
+            }
+            catch (...)
+            {
+                if (!failed.exchange(true))
+                    error = std::current_exception();
+            }
+
+            finish();
+        }
+
+        // a task dropped by an aborting pool fails the batch with broken_promise
+
+        void drop()
+        {
+            if (!failed.exchange(true))
+                error = std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+
+            finish();
+        }
+
+        void finish()
+        {
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                if (error)
+                    promise.set_exception(error);
+                else
+                    promise.set_value();
+
+                delete this;
+            }
+        }
+    };
+
+    // one index of a batch, it reports itself dropped if destroyed before it ran
+
+    template <typename S>
+    struct bulk_task
+    {
+        S* state;
+        size_t index;
+
+        bulk_task(S* state, size_t index) noexcept : state(state), index(index)
+        {
+        }
+
+        bulk_task(bulk_task&& other) noexcept : state(std::exchange(other.state, nullptr)), index(other.index)
+        {
+        }
+
+        void operator()()
+        {
+            (*std::exchange(state, nullptr))(index);
+        }
+
+        ~bulk_task()
+        {
+            if (state)
+                state->drop();
+        }
+    };
+
+    // a bounded lock-free queue shared by all the workers, tasks that find it full
+    // spill over into a locked deque, so producers never block on a slow consumer
+
+    template <size_t N = 1024>
+    class lock_free_queue
+    {
+        public:
+            explicit lock_free_queue(size_t)
+            {
+            }
+
+            void push(task_type&& task, size_t)
+            {
+                if (tasks.try_push(std::move(task)))
+                    return;
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                overflow.push_back(std::move(task));
+                spilled.fetch_add(1, std::memory_order_release);
+            }
+
+            template <typename G>
+            void push_bulk(size_t n, G&& make, size_t index)
+            {
+                for (size_t i = 0; i != n; ++i)
+                     push(make(i), index);
+            }
+
+            bool pop(task_type& task, size_t)
+            {
+                if (auto t = tasks.try_pop())
+                {
+                    task = std::move(*t);
+
+                    return true;
+                }
+
+                if (spilled.load(std::memory_order_acquire) == 0)
+                    return false;
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                if (overflow.empty())
+                    return false;
+
+                task = overflow.pop_front();
+                spilled.fetch_sub(1, std::memory_order_relaxed);
+
+                return true;
+            }
+
+        private:
+            mpmc_ring<task_type, N> tasks;
+
+            std::mutex mutex;
+            std::atomic<size_t> spilled = 0;
+
+            circular_deque<task_type> overflow;
+    };
+
+    // scheduling hints accepted by the policies that order tasks, lane 0 is the most urgent
+
+    struct priority
+    {
+        size_t lane;
+    };
+
+    struct deadline
+    {
+        std::chrono::steady_clock::time_point time;
+    };
+
+    struct numa_node
+    {
+        size_t id;
+    };
+
+    template <typename T>
+    concept schedule_hint = std::is_same_v<T, priority> || std::is_same_v<T, deadline> || std::is_same_v<T, numa_node>;
+
+    // N lanes drained from the most urgent one, a task waiting longer than the aging limit
+    // is served ahead of the more urgent lanes, so a saturated lane can not starve the others
+
+    template <size_t N = 3>
+    class priority_lanes
+    {
+        static_assert(N != 0, "at least one lane is required");
+
+        public:
+            using clock = std::chrono::steady_clock;
+
+            explicit priority_lanes(size_t)
+            {
+            }
+
+            void push(task_type&& task, size_t index)
+            {
+                push(std::move(task), index, priority{N / 2});
+            }
+
+            void push(task_type&& task, size_t, priority p)
+            {
+                auto lane = std::min(p.lane, N - 1);
+                auto now = clock::now();
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                lanes[lane].push_back({ now, std::move(task) });
+                depths[lane].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            template <typename G>
+            void push_bulk(size_t n, G&& make, size_t)
+            {
+                auto now = clock::now();
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                for (size_t i = 0; i != n; ++i)
+                     lanes[N / 2].push_back({ now, make(i) });
+
+                depths[N / 2].fetch_add(n, std::memory_order_relaxed);
+            }
+
+            bool pop(task_type& task, size_t)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                size_t lane = std::find_if(lanes.begin(), lanes.end(), [](auto& l){ return !l.empty(); }) - lanes.begin();
+
+                if (lane == N)
+                    return false;
+
+                if (lane + 1 < N)
+                {
+                    auto now = clock::now();
+
+                    for (size_t i = lane + 1; i != N; ++i)
+                    {
+                         if (!lanes[i].empty() && now - lanes[i].front().time >= limit)
+                         {
+                             lane = i;
+                             break;
+                         }
+                    }
+                }
+
+                task = std::move(lanes[lane].pop_front().task);
+                depths[lane].fetch_sub(1, std::memory_order_relaxed);
+
+                return true;
+            }
+
+            size_t size(size_t lane) const noexcept
+            {
+                return depths[lane].load(std::memory_order_relaxed);
+            }
+
+            void aging(clock::duration d)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                limit = d;
+            }
+
+        private:
+            struct entry
+            {
+                clock::time_point time;
+                task_type task;
+            };
+
+            std::mutex mutex;
+            clock::duration limit = std::chrono::milliseconds(100);
+
+            std::array<circular_deque<entry>, N> lanes;
+            std::array<std::atomic<size_t>, N> depths{};
+    };
+
+    // earliest deadline first, a task posted without a deadline is due after the slack,
+    // so waiting tasks age naturally against the ones posted later
+
+    class deadline_queue
+    {
+        public:
+            using clock = std::chrono::steady_clock;
+
+            explicit deadline_queue(size_t)
+            {
+            }
+
+            void push(task_type&& task, size_t index)
+            {
+                push(std::move(task), index, deadline{clock::now() + slack_});
+            }
+
+            void push(task_type&& task, size_t, deadline d)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                heap.push_back({ d.time, sequence++, std::move(task) });
+                std::push_heap(heap.begin(), heap.end(), later);
+
+                depth.store(heap.size(), std::memory_order_relaxed);
+            }
+
+            template <typename G>
+            void push_bulk(size_t n, G&& make, size_t)
+            {
+                auto time = clock::now() + slack_;
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                for (size_t i = 0; i != n; ++i)
+                {
+                     heap.push_back({ time, sequence++, make(i) });
+                     std::push_heap(heap.begin(), heap.end(), later);
+                }
+
+                depth.store(heap.size(), std::memory_order_relaxed);
+            }
+
+            bool pop(task_type& task, size_t)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                if (heap.empty())
+                    return false;
+
+                std::pop_heap(heap.begin(), heap.end(), later);
+
+                task = std::move(heap.back().task);
+                heap.pop_back();
+
+                depth.store(heap.size(), std::memory_order_relaxed);
+
+                return true;
+            }
+
+            size_t size() const noexcept
+            {
+                return depth.load(std::memory_order_relaxed);
+            }
+
+            void slack(clock::duration d)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slack_ = d;
+            }
+
+        private:
+            struct entry
+            {
+                clock::time_point time;
+                size_t sequence;
+                task_type task;
+            };
+
+            static bool later(const entry& lhs, const entry& rhs) noexcept
+            {
+                return lhs.time != rhs.time ? lhs.time > rhs.time : lhs.sequence > rhs.sequence;
+            }
+
+            std::mutex mutex;
+
+            size_t sequence = 0;
+            clock::duration slack_ = std::chrono::milliseconds(100);
+
+            std::vector<entry> heap;
+            std::atomic<size_t> depth = 0;
+    };
+
+    // parses a sysfs cpu list such as "0-3,8-11"
+
+    inline std::vector<size_t> parse_cpu_list(const std::string& list)
+    {
+        std::vector<size_t> cpus;
+
+        for (size_t pos = 0; pos < list.size(); )
+        {
+             auto end = list.find(',', pos);
+
+             if (end == std::string::npos)
+                 end = list.size();
+
+             auto range = list.substr(pos, end - pos);
+             auto dash = range.find('-');
+
+             if (!range.empty() && range.find_first_not_of("0123456789-") == std::string::npos)
+             {
+                 size_t first = std::stoul(range);
+                 size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+
+                 for (auto cpu = first; cpu <= last; ++cpu)
+                      cpus.push_back(cpu);
+             }
+
+             pos = end + 1;
+        }
+
+        return cpus;
+    }
+
+    // the cpus of each NUMA node read from /sys, entry n is always node n, empty for a memory only node
+    // or a gap in the numbering, a single node holding every cpu when the topology is unknown
+
+    inline std::vector<std::vector<size_t>> numa_nodes()
+    {
+        std::vector<std::vector<size_t>> nodes;
+        std::string list;
+
+        for (auto name : { "online", "possible" })
+        {
+             std::ifstream file(std::string("/sys/devices/system/node/") + name);
+
+             if (file && std::getline(file, list) && !list.empty())
+                 break;
+        }
+
+        auto present = parse_cpu_list(list);
+
+        if (!present.empty())
+            nodes.resize(std::ranges::max(present) + 1);
+
+        for (auto i : present)
+        {
+             std::ifstream file("/sys/devices/system/node/node" + std::to_string(i) + "/cpulist");
+
+             if (file && std::getline(file, list))
+                 nodes[i] = parse_cpu_list(list);
+        }
+
+        if (std::ranges::all_of(nodes, [](auto& cpus){ return cpus.empty(); }))
+        {
+            nodes.clear();
+            nodes.emplace_back(std::max(1u, std::thread::hardware_concurrency()));
+
+            for (size_t i = 0; i != nodes[0].size(); ++i)
+                 nodes[0][i] = i;
+        }
+
+        return nodes;
+    }
+
+    // pins the calling thread to a set of cpus, does nothing where affinity is not supported
+
+    inline bool pin_to_cpus(const std::vector<size_t>& cpus)
+    {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+
+        for (auto cpu : cpus)
+             CPU_SET(cpu, &set);
+
+        return !cpus.empty() && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    // a hint to the cpu that the caller is busy waiting
+
+    inline void cpu_relax() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    struct worker_statistics
+    {
+        uint64_t tasks = 0;
+
+        std::chrono::nanoseconds busy{};
+        std::chrono::nanoseconds idle{};
+    };
+
+    // a point in time view of a pool, the counters beyond the first three stay zero
+    // unless MONSTER_THREAD_POOL_STATISTICS is defined, so they cost nothing when unused
+
+    struct thread_pool_statistics
+    {
+        static constexpr size_t buckets = 40;
+
+        size_t workers = 0;
+        size_t queued = 0;
+        size_t active = 0;
+
+        uint64_t posted = 0;
+        uint64_t completed = 0;
+        uint64_t steals = 0;
+
+        size_t high_water = 0;
+
+        // bucket i counts the latencies in [2^(i-1), 2^i) nanoseconds
+        std::array<uint64_t, buckets> wait_histogram{};
+        std::array<uint64_t, buckets> run_histogram{};
+
+        std::chrono::nanoseconds wait{};
+        std::vector<worker_statistics> per_worker;
+    };
+
+    struct thread_pool_options
+    {
+        size_t size = std::max(1u, std::thread::hardware_concurrency());
+
+        // worker i is pinned to cpus[i % cpus.size()], empty leaves the placement to the scheduler
+        std::vector<size_t> cpus;
+
+        // spread the workers over the NUMA nodes in contiguous groups, each pinned to the cpus of its node
+        bool numa = false;
+
+        // the pool starts min workers and adds more up to size while tasks queue up faster than
+        // the running workers take them, a worker above min exits after keep_alive without work,
+        // min at or above size keeps the pool fixed
+
+        size_t min = std::numeric_limits<size_t>::max();
+        std::chrono::milliseconds keep_alive{1000};
+
+        // an idle worker polls the queue spin times, then yields yield times before it parks,
+        // tasks posted while a worker polls are picked up without waking a parked one
+
+        size_t spin = 0;
+        size_t yield = 0;
+    };
+
+    // a task that takes a std::stop_token ahead of its arguments, and cannot be called without it, is handed the pool's token,
+    // once the token is prepended the task is callable with its arguments alone, so it is never prepended twice
+
+    template <typename F, typename... Args>
+    concept stoppable = std::is_invocable_v<std::decay_t<F>&, std::stop_token&, std::decay_t<Args>&...> &&
+                        !std::is_invocable_v<std::decay_t<F>&, std::decay_t<Args>&...>;
+
+    // drain runs every queued task before the workers exit, abort drops the tasks not yet started,
+    // failing their futures with broken_promise, and requests stop on the pool's stop token
+
+    enum class shutdown_mode
+    {
+        drain,
+        abort
+    };
+
+    template <typename Queue = fifo_queue>
+    class basic_thread_pool
+    {
+        public:
+            basic_thread_pool(size_t size);
+            explicit basic_thread_pool(const thread_pool_options& options);
+
+            template <typename F, typename... Args>
+            constexpr auto post(F&& f, Args&&... args);
+
+            template <typename F, typename... Args>
+            constexpr auto submit(F&& f, Args&&... args);
+
+            template <typename F, typename... Args>
+            void execute(F&& f, Args&&... args);
+
+            template <typename H, typename F, typename... Args>
+            requires schedule_hint<H>
+            constexpr auto post(H hint, F&& f, Args&&... args);
+
+            template <typename H, typename F, typename... Args>
+            requires schedule_hint<H>
+            constexpr auto submit(H hint, F&& f, Args&&... args);
+
+            template <typename H, typename F, typename... Args>
+            requires schedule_hint<H>
+            void execute(H hint, F&& f, Args&&... args);
+
+            template <typename I, typename F>
+            task_future<void> post_bulk(I first, I last, F&& f);
+
+            template <typename I, typename F>
+            task_future<void> parallel_for(I first, I last, size_t grain, F&& f);
+
+            auto schedule() noexcept;
+
+            size_t size() const noexcept;
+            size_t nodes() const noexcept;
+
+            Queue& queue() noexcept;
+            void wait_idle() const noexcept;
+
+            template <typename Rep, typename Period>
+            bool wait_idle_for(const std::chrono::duration<Rep, Period>& timeout);
+
+            std::stop_token get_stop_token() const noexcept;
+            bool request_stop() noexcept;
+
+            void shutdown(shutdown_mode mode = shutdown_mode::drain);
+
+            template <typename Rep, typename Period>
+            bool shutdown_for(const std::chrono::duration<Rep, Period>& timeout);
+
+            thread_pool_statistics snapshot() const;
+
+            ~basic_thread_pool();
+
+        private:
+            void run(size_t index);
+            void notify(size_t n);
+
+            void grow(size_t n);
+            bool retire(size_t index);
+            bool park(uint32_t e);
+
+            void complete();
+            void discard();
+
+            template <typename... H>
+            void push(task_type&& task, const H&... hint);
+            void push(task_type&& task, const numa_node& node);
+
+            template <typename G>
+            void push_bulk(size_t n, G&& make);
+
+            template <typename F, typename... Args>
+            auto packaged(F&& f, Args&&... args);
+
+            template <typename F, typename... Args>
+            auto promised(F&& f, Args&&... args);
+
+            template <typename F, typename... Args>
+            task_type bound(F&& f, Args&&... args);
+
+            size_t worker_index() const noexcept;
+
+            struct context
+            {
+                const void* pool = nullptr;
+                size_t index = npos;
+            };
+
+            static inline thread_local context this_worker;
+
+            std::atomic<bool> stop = false;
+            std::atomic<bool> dropping = false;
+            std::atomic<uint32_t> epoch = 0;
+
+            std::atomic<size_t> idle = 0;
+            std::atomic<size_t> active = 0;
+            std::atomic<size_t> pending = 0;
+            std::atomic<size_t> searching = 0;
+
+            Queue tasks;
+            std::vector<std::thread> workers;
+
+            // a slot is running from the moment its thread is started until it retires,
+            // live and running only change under scaling, elastic pools park on wake
+
+            size_t floor;
+            size_t spin;
+            size_t yield;
+
+            bool elastic;
+            std::chrono::milliseconds keep_alive;
+
+            std::mutex scaling;
+            std::atomic<size_t> live = 0;
+            std::vector<std::atomic<bool>> running;
+
+            std::mutex parking;
+            std::condition_variable wake;
+
+            // wait_idle_for sleeps on drained, the last task to finish notifies it while watchers is nonzero
+
+            std::atomic<size_t> watchers = 0;
+            std::condition_variable drained;
+
+            std::mutex closing;
+            std::stop_source cancellation;
+
+            std::vector<std::vector<size_t>> affinity;
+            std::vector<std::vector<size_t>> groups;
+
+            std::atomic<size_t> next = 0;
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+            using clock = std::chrono::steady_clock;
+
+            // written by their worker only, read by snapshot
+
+            struct alignas(64) counters
+            {
+                std::atomic<uint64_t> tasks = 0;
+                std::atomic<uint64_t> busy = 0;
+                std::atomic<uint64_t> idle = 0;
+                std::atomic<uint64_t> wait = 0;
+
+                std::array<std::atomic<uint64_t>, thread_pool_statistics::buckets> wait_histogram{};
+                std::array<std::atomic<uint64_t>, thread_pool_statistics::buckets> run_histogram{};
+            };
+
+            static void record(std::atomic<uint64_t>& counter, uint64_t n) noexcept
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+
+            static size_t bucket(uint64_t ns) noexcept
+            {
+                return std::min<size_t>(std::bit_width(ns), thread_pool_statistics::buckets - 1);
+            }
+
+            void record_posted(size_t n, size_t depth) noexcept;
+
+            std::atomic<uint64_t> posted = 0;
+            std::atomic<size_t> high_water = 0;
+            std::unique_ptr<counters[]> statistics;
+#endif
+    };
+
+    using thread_pool = basic_thread_pool<>;
+
+    template <typename Queue>
+    basic_thread_pool<Queue>::basic_thread_pool(size_t size) : basic_thread_pool(thread_pool_options{ size })
+    {
+    }
+
+    template <typename Queue>
+    basic_thread_pool<Queue>::basic_thread_pool(const thread_pool_options& options) : tasks(options.size), workers(options.size),
+    floor(std::min(options.min, options.size)), spin(options.spin), yield(options.yield), elastic(floor < options.size),
+    keep_alive(options.keep_alive), running(options.size), affinity(options.size)
+    {
+        auto size = options.size;
+        auto topology = options.cpus.empty() && !options.numa ? std::vector<std::vector<size_t>>() : numa_nodes();
+
+        auto node_of = [&](size_t cpu)
+        {
+            for (size_t n = 0; n != topology.size(); ++n)
+            {
+                 if (std::ranges::find(topology[n], cpu) != topology[n].end())
+                     return n;
+            }
+
+            return size_t(0);
+        };
+
+        // workers are grouped by node, a node local task goes to a worker of its group, group n is always node n,
+        // a node without workers keeps an empty group
+
+        if (!options.cpus.empty())
+        {
+            groups.resize(topology.size());
+
+            for (size_t i = 0; i != size; ++i)
+            {
+                 auto cpu = options.cpus[i % options.cpus.size()];
+
+                 affinity[i] = { cpu };
+                 groups[node_of(cpu)].push_back(i);
+            }
+        }
+        else if (options.numa)
+        {
+            groups.resize(topology.size());
+
+            // workers are spread over the nodes that have cpus only
+
+            std::vector<size_t> populated;
+
+            for (size_t n = 0; n != topology.size(); ++n)
+            {
+                 if (!topology[n].empty())
+                     populated.push_back(n);
+            }
+
+            for (size_t i = 0; i != size; ++i)
+            {
+                 auto n = populated[i * populated.size() / size];
+
+                 affinity[i] = topology[n];
+                 groups[n].push_back(i);
+            }
+        }
+        else
+        {
+            groups.resize(1);
+
+            for (size_t i = 0; i != size; ++i)
+                 groups[0].push_back(i);
+        }
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+        statistics = std::make_unique<counters[]>(size);
+#endif
+
+        grow(floor);
+    }
+
+    template <typename Queue>
+    void basic_thread_pool<Queue>::run(size_t index)
+    {
+        this_worker = { this, index };
+
+        if (!affinity[index].empty())
+            pin_to_cpus(affinity[index]);
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+        auto& counter = statistics[index];
+        auto last = clock::now();
+#endif
+
+        size_t rounds = 0;
+        bool polling = false;
+
+        while (true)
+        {
+            task_type task;
+
+            if (tasks.pop(task, index))
+            {
+                pending.fetch_sub(1);
+
+                if (dropping.load(std::memory_order_relaxed))
+                {
+                    task.reset();
+                    complete();
+
+                    continue;
+                }
+
+                // a poller that found work hands the search over to a parked worker if more is queued
+
+                if (std::exchange(polling, false))
+                {
+                    searching.fetch_sub(1);
+
+                    if (pending.load() != 0)
+                        notify(1);
+                }
+
+                rounds = 0;
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+                auto start = clock::now();
+                uint64_t waited = std::chrono::nanoseconds(start - task.stamp).count();
+
+                record(counter.idle, std::chrono::nanoseconds(start - last).count());
+                record(counter.wait, waited);
+                record(counter.wait_histogram[bucket(waited)], 1);
+#endif
+
+                task();
+                task.reset();
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+                last = clock::now();
+                uint64_t ran = std::chrono::nanoseconds(last - start).count();
+
+                record(counter.busy, ran);
+                record(counter.run_histogram[bucket(ran)], 1);
+                record(counter.tasks, 1);
+#endif
+
+                complete();
+
+                continue;
+            }
+
+            if (rounds < spin + yield && !stop.load())
+            {
+                if (!std::exchange(polling, true))
+                    searching.fetch_add(1);
+
+                if (rounds++ < spin)
+                    cpu_relax();
+                else
+                    std::this_thread::yield();
+
+                continue;
+            }
+
+            // park on the epoch, a producer bumps it before waking anyone, so a wakeup
+            // that lands between the load and the wait makes the wait return at once
+
+            auto e = epoch.load();
+            idle.fetch_add(1);
+
+            // a poller counts as idle before it stops searching, so a producer sees it either way
+
+            if (std::exchange(polling, false))
+                searching.fetch_sub(1);
+
+            bool woken = true;
+
+            if (!stop.load() && pending.load() == 0)
+                woken = park(e);
+
+            idle.fetch_sub(1);
+            rounds = 0;
+
+            if (stop.load() && pending.load() == 0)
+                return;
+
+            if (!woken && retire(index))
+                return;
+        }
+    }
+
+    // returns false if an elastic worker waited keep_alive without being woken
+
+    template <typename Queue>
+    bool basic_thread_pool<Queue>::park(uint32_t e)
+    {
+        if (!elastic)
+        {
+            epoch.wait(e);
+
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(parking);
+
+        return wake.wait_for(lock, keep_alive, [&]{ return epoch.load() != e; });
+    }
+
+    // a worker above the floor leaves its slot, unless a task was queued after it stopped
+    // counting as idle, a producer then either sees the smaller idle or the queued task stays
+
+    template <typename Queue>
+    bool basic_thread_pool<Queue>::retire(size_t index)
+    {
+        std::lock_guard<std::mutex> lock(scaling);
+
+        if (stop.load() || live.load() <= floor)
+            return false;
+
+        live.fetch_sub(1);
+
+        if (pending.load() != 0)
+        {
+            live.fetch_add(1);
+
+            return false;
+        }
+
+        running[index].store(false);
+
+        return true;
+    }
+
+    // starts a worker in a free slot, a retired thread has released its slot and is joined first
+
+    template <typename Queue>
+    void basic_thread_pool<Queue>::grow(size_t n)
+    {
+        if (stop.load())
+            return;
+
+        std::lock_guard<std::mutex> lock(scaling);
+
+        for (; n != 0 && !stop.load() && live.load() != workers.size(); --n)
+        {
+            auto slot = std::ranges::find_if(running, [](auto& r){ return !r.load(); });
+            auto index = size_t(slot - running.begin());
+
+            if (workers[index].joinable())
+                workers[index].join();
+
+            workers[index] = std::thread(&basic_thread_pool::run, this, index);
+
+            slot->store(true);
+            live.fetch_add(1);
+        }
+    }
+
+    template <typename Queue>
+    size_t basic_thread_pool<Queue>::worker_index() const noexcept
+    {
+        return this_worker.pool == this ? this_worker.index : npos;
+    }
+
+    template <typename Queue>
+    size_t basic_thread_pool<Queue>::size() const noexcept
+    {
+        return workers.size();
+    }
+
+    template <typename Queue>
+    thread_pool_statistics basic_thread_pool<Queue>::snapshot() const
+    {
+        thread_pool_statistics stats;
+
+        stats.workers = live.load(std::memory_order_relaxed);
+        stats.queued = pending.load(std::memory_order_relaxed);
+        stats.active = active.load(std::memory_order_relaxed);
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+        uint64_t wait = 0;
+
+        for (size_t i = 0; i != workers.size(); ++i)
+        {
+             auto& counter = statistics[i];
+
+             stats.per_worker.push_back({ counter.tasks.load(std::memory_order_relaxed),
+                                          std::chrono::nanoseconds(counter.busy.load(std::memory_order_relaxed)),
+                                          std::chrono::nanoseconds(counter.idle.load(std::memory_order_relaxed)) });
+
+             stats.completed += stats.per_worker.back().tasks;
+             wait += counter.wait.load(std::memory_order_relaxed);
+
+             for (size_t j = 0; j != thread_pool_statistics::buckets; ++j)
+             {
+                  stats.wait_histogram[j] += counter.wait_histogram[j].load(std::memory_order_relaxed);
+                  stats.run_histogram[j] += counter.run_histogram[j].load(std::memory_order_relaxed);
+             }
+        }
+
+        if constexpr (requires { tasks.steals(); })
+            stats.steals = tasks.steals();
+
+        stats.wait = std::chrono::nanoseconds(wait);
+        stats.posted = posted.load(std::memory_order_relaxed);
+        stats.high_water = high_water.load(std::memory_order_relaxed);
+#endif
+
+        return stats;
+    }
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+    template <typename Queue>
+    void basic_thread_pool<Queue>::record_posted(size_t n, size_t depth) noexcept
+    {
+        posted.fetch_add(n, std::memory_order_relaxed);
+
+        auto peak = high_water.load(std::memory_order_relaxed);
+
+        while (depth > peak && !high_water.compare_exchange_weak(peak, depth, std::memory_order_relaxed));
+    }
+#endif
+
+    template <typename Queue>
+    size_t basic_thread_pool<Queue>::nodes() const noexcept
+    {
+        return groups.size();
+    }
+
+    template <typename Queue>
+    Queue& basic_thread_pool<Queue>::queue() noexcept
+    {
+        return tasks;
+    }
+
+    // blocks until every task posted so far has finished, it must not be called from a worker
+
+    template <typename Queue>
+    void basic_thread_pool<Queue>::wait_idle() const noexcept
+    {
+        for (auto n = active.load(std::memory_order_acquire); n != 0; n = active.load(std::memory_order_acquire))
+             active.wait(n, std::memory_order_acquire);
+    }
+
+    // returns false if tasks are still running when the timeout expires
+
+    template <typename Queue>
+    template <typename Rep, typename Period>
+    bool basic_thread_pool<Queue>::wait_idle_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        watchers.fetch_add(1);
+
+        std::unique_lock<std::mutex> lock(parking);
+        bool idle = drained.wait_for(lock, timeout, [&]{ return active.load() == 0; });
+
+        lock.unlock();
+        watchers.fetch_sub(1);
+
+        return idle;
+    }
+
+    // a task taking a std::stop_token as its first parameter receives this token
+
+    template <typename Queue>
+    std::stop_token basic_thread_pool<Queue>::get_stop_token() const noexcept
+    {
+        return cancellation.get_token();
+    }
+
+    template <typename Queue>
+    bool basic_thread_pool<Queue>::request_stop() noexcept
+    {
+        return cancellation.request_stop();
+    }
+
+    // the workers exit once the queue is empty, tasks posted afterwards are dropped
+
+    template <typename Queue>
+    void basic_thread_pool<Queue>::shutdown(shutdown_mode mode)
+    {
+        if (mode == shutdown_mode::abort)
+        {
+            cancellation.request_stop();
+            dropping.store(true);
+
+            discard();
+        }
+
+        std::lock_guard<std::mutex> lock(closing);
+
+        stop.store(true);
+
+        {
+            std::lock_guard<std::mutex> lock(parking);
+            epoch.fetch_add(1);
+        }
+
+        epoch.notify_all();
+        wake.notify_all();
+
+        // no slot is started or retired once stop is seen under scaling
+
+        {
+            std::lock_guard<std::mutex> lock(scaling);
+        }
+
+        for (auto& worker: workers)
+        {
+             if (worker.joinable())
+                 worker.join();
+        }
+
+        dropping.store(true);
+        discard();
+    }
+
+    // drains for at most timeout, then aborts what is left, returns true if everything ran
+
+    template <typename Queue>
+    template <typename Rep, typename Period>
+    bool basic_thread_pool<Queue>::shutdown_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        bool idle = wait_idle_for(timeout);
+        shutdown(idle ? shutdown_mode::drain : shutdown_mode::abort);
+
+        return idle;
+    }
+
+    template <typename Queue>
+    void basic_thread_pool<Queue>::complete()
+    {
+        if (active.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            active.notify_all();
+
+            if (watchers.load() != 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(parking);
+                }
+
+                drained.notify_all();
+            }
+        }
+    }
+
+    // destroys the queued tasks without running them, which fails their futures
+
+    template <typename Queue>
+    void basic_thread_pool<Queue>::discard()
+    {
+        task_type task;
+
+        while (tasks.pop(task, npos))
+        {
+            pending.fetch_sub(1);
+
+            task.reset();
+            complete();
+        }
+    }
+
+    template <typename Queue>
+    void basic_thread_pool<Queue>::notify(size_t n)
+    {
+        // a worker increments idle before it checks pending, so either
+        // it sees the new tasks or we see it idle and bump the epoch
+
+        auto polling = searching.load();
+        auto waiting = idle.load();
+
+        // the queue outgrows the workers that could take it, so add as many as it is deeper, up to the limit
+
+        if (elastic)
+        {
+            auto depth = pending.load();
+            auto ready = waiting + polling;
+
+            if (depth > ready && live.load() < workers.size())
+                grow(std::min(depth - ready, workers.size() - live.load()));
+        }
+
+        if (n <= polling)
+            return;
+
+        n -= polling;
+
+        if (waiting == 0)
+            return;
+
+        if (elastic)
+        {
+            {
+                std::lock_guard<std::mutex> lock(parking);
+                epoch.fetch_add(1);
+            }
+
+            if (n >= waiting)
+                wake.notify_all();
+            else
+            {
+                for (size_t i = 0; i != n; ++i)
+                     wake.notify_one();
+            }
+
+            return;
+        }
+
+        epoch.fetch_add(1);
+
+        if (n >= waiting)
+            epoch.notify_all();
+        else
+        {
+            for (size_t i = 0; i != n; ++i)
+                 epoch.notify_one();
+        }
+    }
+
+    template <typename Queue>
+    template <typename... H>
+    void basic_thread_pool<Queue>::push(task_type&& task, const H&... hint)
+    {
+        if (dropping.load(std::memory_order_relaxed))
+            return task.reset();
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+        task.stamp = clock::now();
+#endif
+        active.fetch_add(1, std::memory_order_relaxed);
+        tasks.push(std::move(task), worker_index(), hint...);
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+        record_posted(1, pending.fetch_add(1) + 1);
+#else
+        pending.fetch_add(1);
+#endif
+
+        notify(1);
+    }
+
+    // a node local task lands on the deque of a worker of that node, it only leaves the node
+    // when it is stolen, policies with a single shared queue ignore the hint
+
+    template <typename Queue>
+    void basic_thread_pool<Queue>::push(task_type&& task, const numa_node& node)
+    {
+        if (dropping.load(std::memory_order_relaxed))
+            return task.reset();
+
+        // a node unknown to the pool is treated like one without workers
+
+        if (node.id >= groups.size() || groups[node.id].empty())
+            return push(std::move(task));
+
+        auto& group = groups[node.id];
+
+        auto index = worker_index();
+
+        if (std::ranges::find(group, index) == group.end())
+            index = group[next.fetch_add(1, std::memory_order_relaxed) % group.size()];
+
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+        task.stamp = clock::now();
+#endif
+        active.fetch_add(1, std::memory_order_relaxed);
+        tasks.push(std::move(task), index);
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+        record_posted(1, pending.fetch_add(1) + 1);
+#else
+        pending.fetch_add(1);
+#endif
+
+        notify(1);
+    }
+
+    template <typename Queue>
+    template <typename G>
+    void basic_thread_pool<Queue>::push_bulk(size_t n, G&& make)
+    {
+        if (dropping.load(std::memory_order_relaxed))
+        {
+            for (size_t i = 0; i != n; ++i)
+                 make(i);
+
+            return;
+        }
+
+        active.fetch_add(n, std::memory_order_relaxed);
+#ifdef MONSTER_THREAD_POOL_STATISTICS
+        tasks.push_bulk(n, [&, now = clock::now()](size_t i)
+        {
+            task_type task = make(i);
+            task.stamp = now;
+
+            return task;
+        }, worker_index());
+
+        record_posted(n, pending.fetch_add(n) + n);
+#else
+        tasks.push_bulk(n, std::forward<G>(make), worker_index());
+        pending.fetch_add(n);
+#endif
+
+        notify(n);
+    }
+
+    template <typename Queue>
+    template <typename F, typename... Args>
+    auto basic_thread_pool<Queue>::packaged(F&& f, Args&&... args)
+    {
+        if constexpr (stoppable<F, Args...>)
+            return packaged(std::forward<F>(f), cancellation.get_token(), std::forward<Args>(args)...);
+        else
+        {
+            using type = std::packaged_task<std::invoke_result_t<F, Args...>()>;
+            type task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+
+            auto fut = task.get_future();
+
+            return std::pair<task_type, decltype(fut)>([task = std::move(task)] mutable { task(); }, std::move(fut));
+        }
+    }
+
+    template <typename Queue>
+    template <typename F, typename... Args>
+    auto basic_thread_pool<Queue>::promised(F&& f, Args&&... args)
+    {
+        if constexpr (stoppable<F, Args...>)
+            return promised(std::forward<F>(f), cancellation.get_token(), std::forward<Args>(args)...);
+        else
+        {
+            using type = std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>;
+
+            task_promise<type> promise;
+            auto fut = promise.get_future();
+
+            return std::pair<task_type, task_future<type>>([promise = std::move(promise), f = std::forward<F>(f), ...args = std::forward<Args>(args)] mutable
+            {
+                promise.set_from([&]() -> type { return std::invoke(f, args...); });
+            }, std::move(fut));
+        }
+    }
+
+    template <typename Queue>
+    template <typename F, typename... Args>
+    task_type basic_thread_pool<Queue>::bound(F&& f, Args&&... args)
+    {
+        if constexpr (stoppable<F, Args...>)
+            return bound(std::forward<F>(f), cancellation.get_token(), std::forward<Args>(args)...);
+        else if constexpr (sizeof...(Args) == 0)
+            return std::forward<F>(f);
+        else
+            return [f = std::forward<F>(f), ...args = std::forward<Args>(args)] mutable { std::invoke(f, args...); };
+    }
+
+    template <typename Queue>
+    template <typename F, typename... Args>
+    constexpr auto basic_thread_pool<Queue>::post(F&& f, Args&&... args)
+    {
+        auto [task, fut] = packaged(std::forward<F>(f), std::forward<Args>(args)...);
+        push(std::move(task));
+
+        return std::move(fut);
+    }
+
+    template <typename Queue>
+    template <typename F, typename... Args>
+    constexpr auto basic_thread_pool<Queue>::submit(F&& f, Args&&... args)
+    {
+        auto [task, fut] = promised(std::forward<F>(f), std::forward<Args>(args)...);
+        push(std::move(task));
+
+        return std::move(fut);
+    }
+
+    // fire and forget, no future is created, an exception escaping the task terminates the program
+
+    template <typename Queue>
+    template <typename F, typename... Args>
+    void basic_thread_pool<Queue>::execute(F&& f, Args&&... args)
+    {
+        push(bound(std::forward<F>(f), std::forward<Args>(args)...));
+    }
+
+    // the hinted overloads need a policy that orders tasks, such as priority_lanes or deadline_queue
+
+    template <typename Queue>
+    template <typename H, typename F, typename... Args>
+    requires schedule_hint<H>
+    constexpr auto basic_thread_pool<Queue>::post(H hint, F&& f, Args&&... args)
+    {
+        auto [task, fut] = packaged(std::forward<F>(f), std::forward<Args>(args)...);
+        push(std::move(task), hint);
+
+        return std::move(fut);
+    }
+
+    template <typename Queue>
+    template <typename H, typename F, typename... Args>
+    requires schedule_hint<H>
+    constexpr auto basic_thread_pool<Queue>::submit(H hint, F&& f, Args&&... args)
+    {
+        auto [task, fut] = promised(std::forward<F>(f), std::forward<Args>(args)...);
+        push(std::move(task), hint);
+
+        return std::move(fut);
+    }
+
+    template <typename Queue>
+    template <typename H, typename F, typename... Args>
+    requires schedule_hint<H>
+    void basic_thread_pool<Queue>::execute(H hint, F&& f, Args&&... args)
+    {
+        push(bound(std::forward<F>(f), std::forward<Args>(args)...), hint);
+    }
+
+    template <typename Queue>
+    template <typename I, typename F>
+    task_future<void> basic_thread_pool<Queue>::post_bulk(I first, I last, F&& f)
+    {
+        auto n = index_distance(first, last);
+
+        if constexpr (!indexable<I>)
+        {
+            return post_bulk(size_t(0), n, [starts = index_strides(first, n, 1), f = std::forward<F>(f)](size_t i) mutable
+            {
+                f(*starts[i]);
+            });
+        }
+        else
+        {
+            auto call = [first, f = std::forward<F>(f)](size_t i) mutable
+            {
+                f(index_at(first, i));
+            };
+
+            auto state = new bulk_state<decltype(call)>{ std::move(call), n };
+            auto fut = state->promise.get_future();
+
+            if (n == 0)
+            {
+                state->promise.set_value();
+                delete state;
+            }
+            else
+                push_bulk(n, [state](size_t i) -> task_type { return bulk_task(state, i); });
+
+            return fut;
+        }
+    }
+
+    template <typename Queue>
+    template <typename I, typename F>
+    task_future<void> basic_thread_pool<Queue>::parallel_for(I first, I last, size_t grain, F&& f)
+    {
+        auto n = index_distance(first, last);
+
+        if (grain == 0)
+            grain = std::max<size_t>(1, n / (4 * std::max<size_t>(1, size())));
+
+        if constexpr (!indexable<I>)
+        {
+            return post_bulk(size_t(0), (n + grain - 1) / grain, [=, starts = index_strides(first, n, grain), f = std::forward<F>(f)](size_t chunk) mutable
+            {
+                auto it = starts[chunk];
+
+                for (size_t i = chunk * grain; i != std::min(n, (chunk + 1) * grain); ++i, ++it)
+                     f(*it);
+            });
+        }
+        else
+        {
+            return post_bulk(size_t(0), (n + grain - 1) / grain, [=, f = std::forward<F>(f)](size_t chunk) mutable
+            {
+                for (size_t i = chunk * grain; i != std::min(n, (chunk + 1) * grain); ++i)
+                     f(index_at(first, i));
+            });
+        }
+    }
+
+    // co_await pool.schedule() resumes the coroutine on a worker
+
+    template <typename Queue>
+    auto basic_thread_pool<Queue>::schedule() noexcept
+    {
+        struct awaiter
+        {
+            // a resumption dropped by an aborting pool still resumes the coroutine, on the
+            // dropping thread, and co_await throws broken_promise so the coroutine unwinds
+
+            struct resumer
+            {
+                std::coroutine_handle<> handle;
+                bool* dropped;
+
+                resumer(std::coroutine_handle<> handle, bool* dropped) noexcept : handle(handle), dropped(dropped)
+                {
+                }
+
+                resumer(resumer&& other) noexcept : handle(std::exchange(other.handle, nullptr)), dropped(other.dropped)
+                {
+                }
+
+                void operator()()
+                {
+                    std::exchange(handle, nullptr).resume();
+                }
+
+                ~resumer()
+                {
+                    if (handle)
+                    {
+                        *dropped = true;
+                        handle.resume();
+                    }
+                }
+            };
+
+            basic_thread_pool* pool;
+            bool dropped = false;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                pool->execute(resumer(handle, &dropped));
+            }
+
+            void await_resume() const
+            {
+                if (dropped)
+                    throw std::future_error(std::future_errc::broken_promise);
+            }
+        };
+
+        return awaiter{this};
+    }
+
+    template <typename Queue>
+    basic_thread_pool<Queue>::~basic_thread_pool()
+    {
+        shutdown(shutdown_mode::drain);
     }
 }
 